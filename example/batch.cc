@@ -0,0 +1,121 @@
+/************************************************************************************
+ *
+ * Author: Thomas Dickerson
+ * Copyright: 2021, Geopipe, Inc.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ************************************************************************************/
+
+
+#include <functional-cxx/batch.hpp>
+
+#include <numeric>
+#include <optional>
+#include <set>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "example-support.hpp"
+
+using namespace com::geopipe::functional;
+
+int main() {
+	std::vector<int> data(100000);
+	std::iota(data.begin(), data.end(), 0);
+
+	{
+		std::vector<int> joined;
+		std::size_t batches = 0;
+		bool sized = true;
+		std::set<const int*> buffers;
+		for(auto s = batch(streamOf(data), 7); s; s = s->tail(), ++batches) {
+			const Batch<int>& b = s->head();
+			sized &= b.size() == (joined.size() + 7 <= data.size() ? 7 : data.size() % 7);
+			joined.insert(joined.end(), b.begin(), b.end());
+			buffers.insert(b.data());
+		}
+		check(joined == data && sized && batches == (data.size() + 6) / 7, "batch: consecutive batches of n, the last shorter");
+		check(buffers.size() <= 4, "batch: ...recycling their storage when released");
+	}
+
+	{
+		auto s = batch(streamOf(data), 1000);
+		std::vector<int> kept = Batch<int>(s->head()).take();
+		check(kept == std::vector<int>(data.begin(), data.begin() + 1000), "Batch::take: moves the elements out");
+
+		bool threw = false;
+		try {
+			batch(streamOf(data), 0);
+		} catch(const std::invalid_argument&) {
+			threw = true;
+		}
+		check(threw, "batch: a zero size throws std::invalid_argument");
+	}
+
+	{
+		std::size_t pulled = 0;
+		auto s = batch(Stream<int>::Generate([&pulled]() -> std::optional<int> {
+			return int(pulled++);
+		}), 4);
+		check(s->head().size() == 4 && pulled == 4, "batch: a full batch pulls nothing beyond its own elements");
+	}
+
+	{
+		// Bound each batch to 20 characters, except for a single longer string.
+		std::vector<std::string> words{"alpha", "beta", "gamma", "delta", "a-much-longer-than-twenty-character-word", "epsilon", "zeta"};
+		auto bytes = [](const std::vector<std::string>& items, const std::string& next){
+			std::size_t n = next.size();
+			for(const auto& w : items) {
+				n += w.size();
+			}
+			return n <= 20;
+		};
+		std::vector<std::size_t> sizes;
+		for(auto s = batchBy(streamOf(words), bytes); s; s = s->tail()) {
+			sizes.push_back(s->head().size());
+		}
+		check(sizes == std::vector<std::size_t>({4, 1, 2}), "batchBy: bounded by a predicate");
+	}
+
+	{
+		std::vector<int> keys{1, 1, 2, 2, 2, 1, 3};
+		std::vector<std::size_t> runs;
+		for(auto s = groupAdjacentBy(streamOf(keys), [](int k){ return k; }); s; s = s->tail()) {
+			runs.push_back(s->head().size());
+		}
+		check(runs == std::vector<std::size_t>({2, 3, 1, 1}), "groupAdjacentBy: runs of equal keys");
+	}
+
+	{
+		// A `Batch` may be released on another thread.
+		auto s = batch(streamOf(data), 100);
+		std::vector<Batch<int>> handed;
+		for(int i = 0; i < 100; ++i, s = s->tail()) {
+			handed.push_back(s->head());
+		}
+		std::thread consumer([handed = std::move(handed)]() mutable {
+			handed.clear();
+		});
+		long sum = 0;
+		for(; s; s = s->tail()) {
+			sum += std::accumulate(s->head().begin(), s->head().end(), 0L);
+		}
+		consumer.join();
+		check(sum == std::accumulate(data.begin() + 10000, data.end(), 0L), "Batch: released on another thread");
+	}
+	return checkStatus();
+}
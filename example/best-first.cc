@@ -0,0 +1,142 @@
+/************************************************************************************
+ *
+ * Author: Thomas Dickerson
+ * Copyright: 2021, Geopipe, Inc.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ************************************************************************************/
+
+
+#include <functional-cxx/best-first.hpp>
+
+#include <cstdint>
+#include <cstdlib>
+#include <deque>
+#include <random>
+#include <vector>
+
+#include "example-support.hpp"
+
+using namespace com::geopipe::functional;
+
+constexpr int kSide = 40;
+
+struct Grid {
+	std::vector<bool> wall;
+
+	bool open(int x, int y) const {
+		return x >= 0 && y >= 0 && x < kSide && y < kSide && !wall[y * kSide + x];
+	}
+
+	/// Breadth-first distances from `start`, as an independent reference; -1 if unreachable.
+	std::vector<int> distances(int start) const {
+		std::vector<int> dist(kSide * kSide, -1);
+		std::deque<int> queue{start};
+		dist[start] = 0;
+		while(!queue.empty()) {
+			int v = queue.front();
+			queue.pop_front();
+			for(auto [dx, dy] : {std::pair{1, 0}, {-1, 0}, {0, 1}, {0, -1}}) {
+				int x = v % kSide + dx, y = v / kSide + dy;
+				if(open(x, y) && dist[y * kSide + x] < 0) {
+					dist[y * kSide + x] = dist[v] + 1;
+					queue.push_back(y * kSide + x);
+				}
+			}
+		}
+		return dist;
+	}
+};
+
+int main() {
+	std::mt19937 rng(11);
+	Grid grid{std::vector<bool>(kSide * kSide)};
+	for(std::size_t i = 1; i + 1 < grid.wall.size(); ++i) {
+		grid.wall[i] = rng() % 4 == 0;
+	}
+	const int goal = kSide * kSide - 1;
+	std::vector<int> dist = grid.distances(0);
+
+	std::size_t expansions = 0;
+	auto successors = [&](int v, auto && yield){
+		++expansions;
+		for(auto [dx, dy] : {std::pair{1, 0}, {-1, 0}, {0, 1}, {0, -1}}) {
+			int x = v % kSide + dx, y = v / kSide + dy;
+			if(grid.open(x, y)) {
+				yield(y * kSide + x, 1);
+			}
+		}
+	};
+	auto manhattan = [](int v){
+		return (kSide - 1 - v % kSide) + (kSide - 1 - v / kSide);
+	};
+
+	// Uniform-cost search expands everything, once, at its breadth-first distance, in order.
+	bool exact = true, ordered = true;
+	std::vector<int> seen(kSide * kSide);
+	int last = 0;
+	std::size_t reached = 0;
+	for(auto s = bestFirstStream<int, int>(0, successors, [](int){ return 0; }); s; s = s->tail()) {
+		const auto& e = s->head();
+		exact &= e.cost == dist[e.state] && e.estimate == e.cost;
+		ordered &= last <= e.estimate;
+		last = e.estimate;
+		++seen[e.state];
+		++reached;
+	}
+	bool once = true;
+	std::size_t reachable = 0;
+	for(int v = 0; v < kSide * kSide; ++v) {
+		once &= seen[v] == (dist[v] >= 0 ? 1 : 0);
+		reachable += dist[v] >= 0;
+	}
+	check(exact && once && reached == reachable, "bestFirstStream: uniform-cost search expands each reachable state once, at its shortest cost");
+	check(ordered, "bestFirstStream: states are expanded in non-decreasing order of estimate");
+
+	// A* stops where the consumer stops, and expands fewer states than uniform-cost search.
+	check(dist[goal] > 0, "grid: the goal is reachable");
+	expansions = 0;
+	auto found = bestFirstStream<int, int>(0, successors, manhattan)->find([&](const auto& e){ return e.state == goal; });
+	std::size_t astar = expansions;
+	expansions = 0;
+	bestFirstStream<int, int>(0, successors, [](int){ return 0; })->find([&](const auto& e){ return e.state == goal; });
+	check(found && found->head().cost == dist[goal], "bestFirstStream: A* finds the goal at its shortest cost");
+	check(astar < expansions, "bestFirstStream: the Manhattan heuristic expands fewer states than uniform-cost search");
+
+	// A beam keeps going on an open grid, though it may no longer be optimal.
+	Grid empty{std::vector<bool>(kSide * kSide)};
+	auto beam = bestFirstStream<int, int>(0, [&](int v, auto && yield){
+		for(auto [dx, dy] : {std::pair{1, 0}, {-1, 0}, {0, 1}, {0, -1}}) {
+			int x = v % kSide + dx, y = v / kSide + dy;
+			if(empty.open(x, y)) {
+				yield(y * kSide + x, 1);
+			}
+		}
+	}, manhattan, SearchOptions{4})->find([&](const auto& e){ return e.state == goal; });
+	check(beam && beam->head().cost >= 2 * (kSide - 1), "bestFirstStream: a narrow beam still reaches the goal on an open grid");
+
+	// States that are themselves 32-bit integers are not confused with the arena's indices.
+	// Reaching 1000 from 1 by incrementing or doubling takes (bit length - 1) + (popcount - 1) = 9 + 5 steps.
+	auto doubling = bestFirstStream<std::uint32_t, int>(1, [](std::uint32_t v, auto && yield){
+		if(v < 1000) {
+			yield(v + 1, 1);
+		}
+		if(2 * v <= 1000) {
+			yield(2 * v, 1);
+		}
+	}, [](std::uint32_t){ return 0; })->find([](const auto& e){ return e.state == 1000; });
+	check(doubling && doubling->head().cost == 14, "bestFirstStream: over std::uint32_t states");
+	return checkStatus();
+}
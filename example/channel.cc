@@ -0,0 +1,110 @@
+/************************************************************************************
+ *
+ * Author: Thomas Dickerson
+ * Copyright: 2021, Geopipe, Inc.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ************************************************************************************/
+
+
+#include <functional-cxx/channel.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <future>
+#include <thread>
+#include <vector>
+
+#include "example-support.hpp"
+
+using namespace com::geopipe::functional;
+
+int main() {
+	const int producers = 4, perProducer = 25000;
+
+	{
+		// Each producer thread owns a `Producer`, and the channel closes when the last is released.
+		auto channel = std::make_shared<Channel<int>>(64, 16);
+		std::vector<Channel<int>::Producer> handles;
+		for(int p = 0; p < producers; ++p) {
+			handles.push_back(channel->producer());
+		}
+		std::vector<std::thread> threads;
+		for(int p = 0; p < producers; ++p) {
+			threads.emplace_back([p, handle = std::move(handles[p])]() mutable {
+				for(int i = 0; i < perProducer; ++i) {
+					handle.push(p * perProducer + i);
+				}
+			});
+		}
+		handles.clear();
+		std::vector<int> seen;
+		std::vector<int> last(producers, -1);
+		bool ordered = true;
+		for(auto chunks = channel->chunks(128); chunks; chunks = chunks->tail()) {
+			for(int v : chunks->head()) {
+				int p = v / perProducer;
+				ordered &= last[p] < v;
+				last[p] = v;
+				seen.push_back(v);
+			}
+		}
+		for(auto& t : threads) {
+			t.join();
+		}
+		std::sort(seen.begin(), seen.end());
+		bool complete = seen.size() == std::size_t(producers * perProducer);
+		for(std::size_t i = 0; complete && i < seen.size(); ++i) {
+			complete = seen[i] == int(i);
+		}
+		check(complete, "every value from every producer arrives exactly once");
+		check(ordered, "values from any one producer arrive in the order pushed");
+	}
+
+	{
+		// Move-assigning a `Producer` over another must release the claim it overwrites.
+		auto channel = std::make_shared<Channel<int>>(16);
+		{
+			auto p1 = channel->producer();
+			auto p2 = channel->producer();
+			p1.push(1);
+			p1 = std::move(p2);
+			p1.push(2);
+		}
+		auto sum = std::async(std::launch::async, [channel](){
+			int total = 0;
+			for(auto s = channel->stream(); s; s = s->tail()) {
+				total += s->head();
+			}
+			return total;
+		});
+		bool finished = sum.wait_for(std::chrono::seconds(10)) == std::future_status::ready;
+		check(finished && sum.get() == 3, "the channel closes once every Producer, including move-assigned ones, is released");
+		if(!finished) {
+			channel->close();
+		}
+	}
+
+	{
+		// After an explicit close, pushes are rejected but accepted values are still delivered.
+		auto channel = std::make_shared<Channel<int>>(16);
+		bool accepted = channel->push(1) && channel->push(2);
+		channel->close();
+		bool rejected = !channel->push(3);
+		std::vector<int> seen = toVector(channel->stream());
+		check(accepted && rejected && seen == std::vector<int>{1, 2}, "close rejects later pushes, and drains the earlier ones");
+	}
+	return checkStatus();
+}
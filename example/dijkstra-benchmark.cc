@@ -0,0 +1,137 @@
+/************************************************************************************
+ *
+ * Author: Thomas Dickerson
+ * Copyright: 2021, Geopipe, Inc.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ************************************************************************************/
+
+#include <functional-cxx/adjacency-array.hpp>
+#include <functional-cxx/dijkstra.hpp>
+
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <functional>
+#include <iostream>
+#include <limits>
+#include <queue>
+#include <random>
+#include <vector>
+
+using namespace com::geopipe::functional;
+
+using Graph = AdjacencyArray<std::uint32_t>;
+
+/*****************************************************
+ * A synthetic "road network": a jittered grid where
+ * some streets are missing, and every 32nd row and
+ * column is a faster arterial road.
+ *****************************************************/
+Graph roadLikeGraph(std::size_t width, std::size_t height, std::uint32_t seed) {
+	std::mt19937 rng(seed);
+	std::uniform_int_distribution<std::uint32_t> length(10, 100);
+	std::bernoulli_distribution missing(0.15);
+	std::vector<Graph::Arc> arcs;
+	arcs.reserve(width * height * 4);
+	auto road = [&](std::size_t a, std::size_t b, bool arterial) {
+		if(!arterial && missing(rng)) {
+			return;
+		}
+		std::uint32_t w = length(rng) / (arterial ? 4 : 1) + 1;
+		arcs.push_back(Graph::Arc{a, b, w});
+		arcs.push_back(Graph::Arc{b, a, w});
+	};
+	for(std::size_t y = 0; y < height; ++y) {
+		for(std::size_t x = 0; x < width; ++x) {
+			std::size_t v = y * width + x;
+			if(x + 1 < width) {
+				road(v, v + 1, y % 32 == 0);
+			}
+			if(y + 1 < height) {
+				road(v, v + width, x % 32 == 0);
+			}
+		}
+	}
+	return Graph(width * height, arcs);
+}
+
+/// Textbook eager Dijkstra with a binary heap and lazy deletion, for comparison.
+std::vector<std::uint32_t> baselineDijkstra(const Graph &g, std::size_t source) {
+	using Item = std::pair<std::uint32_t, std::size_t>;
+	std::vector<std::uint32_t> dist(g.vertexCount(), std::numeric_limits<std::uint32_t>::max());
+	std::priority_queue<Item, std::vector<Item>, std::greater<Item>> queue;
+	dist[source] = 0;
+	queue.emplace(0, source);
+	while(!queue.empty()) {
+		auto [d, v] = queue.top();
+		queue.pop();
+		if(d != dist[v]) {
+			continue;
+		}
+		for(const auto& e : g.neighbors(v)) {
+			if(d + e.weight < dist[e.target]) {
+				dist[e.target] = d + e.weight;
+				queue.emplace(dist[e.target], e.target);
+			}
+		}
+	}
+	return dist;
+}
+
+template<class F>
+double millis(F && f) {
+	auto start = std::chrono::steady_clock::now();
+	f();
+	return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+int main(int argc, const char *argv[]) {
+	std::size_t side = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 1000;
+	Graph g = roadLikeGraph(side, side, 42);
+	std::size_t source = (side / 2) * side + side / 2;
+	std::cout << g.vertexCount() << " vertices, " << g.edgeCount() << " edges" << std::endl;
+
+	std::vector<std::uint32_t> expected;
+	std::cout << "baseline full SSSP:    " << millis([&](){ expected = baselineDijkstra(g, source); }) << " ms" << std::endl;
+
+	std::size_t settled = 0;
+	bool agrees = true;
+	std::cout << "dijkstraStream full:   " << millis([&](){
+		for(auto s = dijkstraStream(g, source); s; s = s->tail()) {
+			agrees &= (s->head().distance == expected[s->head().vertex]);
+			++settled;
+		}
+	}) << " ms (" << settled << " settled, " << (agrees ? "distances agree" : "DISTANCES DISAGREE") << ")" << std::endl;
+
+	std::size_t budget = g.vertexCount() / 100;
+	std::cout << "dijkstraStream 1%:     " << millis([&](){
+		std::size_t n = 0;
+		for(auto s = dijkstraStream(g, source); s && n < budget; s = s->tail()) {
+			++n;
+		}
+	}) << " ms" << std::endl;
+
+	std::size_t target = source + side / 8;
+	std::uint32_t distance = 0;
+	std::cout << "point-to-point query:  " << millis([&](){
+		auto s = dijkstraStream(g, source);
+		while(s && s->head().vertex != target) {
+			s = s->tail();
+		}
+		distance = s ? s->head().distance : 0;
+	}) << " ms (distance " << distance << ")" << std::endl;
+	return agrees ? 0 : 1;
+}
@@ -0,0 +1,101 @@
+/************************************************************************************
+ *
+ * Author: Thomas Dickerson
+ * Copyright: 2021, Geopipe, Inc.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ************************************************************************************/
+
+
+#include <functional-cxx/adjacency-array.hpp>
+#include <functional-cxx/dijkstra.hpp>
+
+#include <cstdint>
+#include <limits>
+#include <random>
+#include <stdexcept>
+#include <vector>
+
+#include "example-support.hpp"
+
+using namespace com::geopipe::functional;
+
+using Graph = AdjacencyArray<std::uint32_t>;
+constexpr std::uint32_t kUnreachable = std::numeric_limits<std::uint32_t>::max();
+
+/// Bellman-Ford, as an independent reference.
+std::vector<std::uint32_t> reference(std::size_t n, const std::vector<Graph::Arc>& arcs, std::size_t source) {
+	std::vector<std::uint32_t> dist(n, kUnreachable);
+	dist[source] = 0;
+	for(bool changed = true; changed;) {
+		changed = false;
+		for(const auto& a : arcs) {
+			if(dist[a.source] != kUnreachable && dist[a.source] + a.weight < dist[a.target]) {
+				dist[a.target] = dist[a.source] + a.weight;
+				changed = true;
+			}
+		}
+	}
+	return dist;
+}
+
+int main() {
+	std::mt19937 rng(5);
+	const std::size_t n = 2000;
+	std::vector<Graph::Arc> arcs;
+	for(int i = 0; i < 8000; ++i) {
+		// Vertices past 1900 only have out-edges, so they are unreachable.
+		arcs.push_back(Graph::Arc{rng() % n, rng() % 1900, std::uint32_t(rng() % 50)});
+	}
+	Graph g(n, arcs);
+	std::vector<std::uint32_t> expected = reference(n, arcs, 0);
+
+	std::vector<std::uint32_t> dist(n, kUnreachable);
+	std::vector<std::size_t> pred(n, kNoVertex);
+	bool ordered = true, once = true;
+	std::uint32_t last = 0;
+	for(auto s = dijkstraStream(g, 0); s; s = s->tail()) {
+		const auto& v = s->head();
+		ordered &= last <= v.distance;
+		last = v.distance;
+		once &= dist[v.vertex] == kUnreachable;
+		dist[v.vertex] = v.distance;
+		pred[v.vertex] = v.predecessor;
+	}
+	check(dist == expected, "dijkstraStream: settles exactly the reachable vertices, at their shortest distances");
+	check(ordered && once, "dijkstraStream: each vertex once, in non-decreasing order of distance");
+
+	bool tight = pred[0] == kNoVertex;
+	for(std::size_t v = 1; v < n; ++v) {
+		if(dist[v] == kUnreachable) {
+			continue;
+		}
+		bool found = false;
+		for(const auto& e : g.neighbors(pred[v])) {
+			found |= e.target == v && dist[pred[v]] + e.weight == dist[v];
+		}
+		tight &= found;
+	}
+	check(tight, "dijkstraStream: predecessors form shortest paths");
+
+	bool threw = false;
+	try {
+		dijkstraStream(g, n);
+	} catch(const std::out_of_range&) {
+		threw = true;
+	}
+	check(threw, "dijkstraStream: a missing source throws std::out_of_range");
+	return checkStatus();
+}
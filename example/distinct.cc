@@ -0,0 +1,100 @@
+/************************************************************************************
+ *
+ * Author: Thomas Dickerson
+ * Copyright: 2021, Geopipe, Inc.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ************************************************************************************/
+
+
+#include <functional-cxx/distinct.hpp>
+
+#include <cstdint>
+#include <random>
+#include <stdexcept>
+#include <unordered_set>
+#include <vector>
+
+#include "example-support.hpp"
+
+using namespace com::geopipe::functional;
+
+int main() {
+	std::mt19937_64 rng(29);
+	std::vector<std::uint64_t> data(200000);
+	for(auto& x : data) {
+		x = rng() % 50000;
+	}
+	std::vector<std::uint64_t> firsts;
+	std::unordered_set<std::uint64_t> seen;
+	for(auto x : data) {
+		if(seen.insert(x).second) {
+			firsts.push_back(x);
+		}
+	}
+
+	check(toVector(distinct(streamOf(data))) == firsts, "distinct: first occurrences, in order");
+
+	{
+		auto byResidue = toVector(distinctBy(streamOf(data), [](std::uint64_t x){ return x % 100; }));
+		bool firstOfEach = byResidue.size() == 100;
+		std::unordered_set<std::uint64_t> residues;
+		for(auto x : byResidue) {
+			firstOfEach &= residues.insert(x % 100).second;
+		}
+		check(firstOfEach, "distinctBy: one element per key");
+	}
+
+	{
+		auto approx = toVector(distinctApprox(streamOf(data)));
+		std::unordered_set<std::uint64_t> emitted(approx.begin(), approx.end());
+		check(emitted.size() == approx.size(), "distinctApprox: never emits a duplicate");
+		check(approx.size() <= firsts.size() && approx.size() >= 0.998 * double(firsts.size()), "distinctApprox: ...and rarely drops a new key");
+	}
+
+	{
+		// Deliveries retried a few places later, then a key recurring much later.
+		std::vector<int> deliveries;
+		for(int i = 0; i < 1000; ++i) {
+			deliveries.push_back(i);
+			if(i >= 3) {
+				deliveries.push_back(i - 3);
+			}
+		}
+		deliveries.push_back(0);
+		std::vector<int> expected(1000);
+		for(int i = 0; i < 1000; ++i) {
+			expected[i] = i;
+		}
+		expected.push_back(0);
+		check(toVector(distinctRecentBy(streamOf(deliveries), [](int x){ return x; }, 64)) == expected, "distinctRecentBy: drops recent repeats, in bounded memory");
+
+		bool threw = false;
+		try {
+			distinctRecentBy(streamOf(deliveries), [](int x){ return x; }, 0);
+		} catch(const std::invalid_argument&) {
+			threw = true;
+		}
+		check(threw, "distinctRecentBy: a zero capacity throws std::invalid_argument");
+	}
+
+	{
+		// A million rejected elements in a row are skipped iteratively.
+		std::vector<int> repeats(1000000, 7);
+		repeats.push_back(8);
+		check(toVector(distinct(streamOf(repeats))) == std::vector<int>({7, 8}), "distinct: long runs of duplicates");
+	}
+	return checkStatus();
+}
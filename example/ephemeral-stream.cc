@@ -0,0 +1,83 @@
+/************************************************************************************
+ *
+ * Author: Thomas Dickerson
+ * Copyright: 2021, Geopipe, Inc.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ************************************************************************************/
+
+
+#include <functional-cxx/static-stream.hpp>
+
+#include <cstdint>
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include "example-support.hpp"
+
+using namespace com::geopipe::functional;
+
+/// An API boundary: `EphemeralStream` names a pipeline's type without naming its stages.
+long sumOfSquares(EphemeralStream<int> s) {
+	return std::move(s).map([](int x){ return long(x) * x; }).fold(0L, [](long a, long b){ return a + b; });
+}
+
+int main() {
+	{
+		// Fibonacci numbers, unfolded from a single mutable state.
+		auto fib = unfold(std::pair<std::uint64_t, std::uint64_t>{0, 1}, [](auto& s) -> std::optional<std::uint64_t> {
+			std::uint64_t e = s.first;
+			s = {s.second, s.first + s.second};
+			return e;
+		});
+		check((std::move(fib).take(10).fold(std::vector<std::uint64_t>(), [](auto v, std::uint64_t e){
+			v.push_back(e);
+			return v;
+		}) == std::vector<std::uint64_t>{0, 1, 1, 2, 3, 5, 8, 13, 21, 34}), "unfold: Fibonacci numbers");
+	}
+
+	{
+		std::vector<int> powers;
+		for(int x : iterate(1, [](int x){ return 2 * x; }).take(8)) {
+			powers.push_back(x);
+		}
+		check((powers == std::vector<int>{1, 2, 4, 8, 16, 32, 64, 128}), "iterate: powers of two");
+	}
+
+	check(sumOfSquares(iterate(1, [](int x){ return x + 1; }).take(10).ephemeral()) == 385, "EphemeralStream: across an API boundary");
+	check(sumOfSquares(fromStream(streamOf(std::vector<int>{3, 4})).ephemeral()) == 25, "EphemeralStream: from a Stream");
+
+	{
+		// `fromStream` only retains the current cell.
+		auto head = streamOf(std::vector<int>{1, 2, 3, 4});
+		std::weak_ptr<Stream<int>> first = head;
+		auto pass = fromStream(std::move(head));
+		std::optional<int> a = pass.next(), b = pass.next();
+		check(a == 1 && b == 2 && first.expired(), "fromStream: visited cells are released");
+	}
+
+	{
+		// An ephemeral pipeline only becomes a memoized `Stream` when a second pass is needed.
+		std::size_t steps = 0;
+		auto s = iterate(1, [&steps](int x){
+			++steps;
+			return 3 * x;
+		}).take(5).ephemeral().erase();
+		std::vector<int> once = toVector(s), twice = toVector(s);
+		check(once == twice && (once == std::vector<int>{1, 3, 9, 27, 81}) && steps == 4, "EphemeralStream::erase: multiple passes over one evaluation");
+	}
+	return checkStatus();
+}
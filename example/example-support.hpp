@@ -0,0 +1,68 @@
+#pragma once
+/************************************************************************************
+ *
+ * Author: Thomas Dickerson
+ * Copyright: 2021, Geopipe, Inc.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ************************************************************************************/
+
+#include <cstddef>
+#include <iostream>
+#include <memory>
+#include <optional>
+#include <vector>
+
+#include <functional-cxx/stream.hpp>
+
+/*****************************************************
+ * Checks for the examples: each prints what it
+ * checked, and `main` returns `checkStatus()`, so an
+ * example exits non-zero if anything went wrong.
+ *****************************************************/
+inline std::size_t& checkFailures() {
+	static std::size_t failures = 0;
+	return failures;
+}
+
+inline bool check(bool ok, const char *what) {
+	std::cout << (ok ? "ok:   " : "FAIL: ") << what << std::endl;
+	if(!ok) {
+		++checkFailures();
+	}
+	return ok;
+}
+
+inline int checkStatus() {
+	return checkFailures() ? 1 : 0;
+}
+
+/// A `Stream` of copies of the elements of `data`, which it keeps alive.
+template<class E>
+std::shared_ptr<com::geopipe::functional::Stream<E>> streamOf(std::vector<E> data) {
+	return com::geopipe::functional::Stream<E>::Generate([data = std::move(data), i = std::size_t(0)]() mutable -> std::optional<E> {
+		return i < data.size() ? std::optional<E>(data[i++]) : std::nullopt;
+	});
+}
+
+/// The elements of `stream`, consumed into a vector.
+template<class E>
+std::vector<E> toVector(std::shared_ptr<com::geopipe::functional::Stream<E>> stream) {
+	std::vector<E> result;
+	for(; stream; stream = stream->tail()) {
+		result.push_back(stream->head());
+	}
+	return result;
+}
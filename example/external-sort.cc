@@ -0,0 +1,136 @@
+/************************************************************************************
+ *
+ * Author: Thomas Dickerson
+ * Copyright: 2021, Geopipe, Inc.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ************************************************************************************/
+
+
+#include <functional-cxx/external-sort.hpp>
+
+#include <algorithm>
+#include <cstdint>
+#include <filesystem>
+#include <functional>
+#include <random>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "example-support.hpp"
+
+using namespace com::geopipe::functional;
+namespace fs = std::filesystem;
+
+/// Length-prefixed strings.
+struct StringSerializer {
+	void write(std::ostream& out, const std::string& s) const {
+		std::uint32_t n = std::uint32_t(s.size());
+		out.write(reinterpret_cast<const char*>(&n), sizeof(n));
+		out.write(s.data(), std::streamsize(n));
+	}
+
+	std::optional<std::string> read(std::istream& in) const {
+		std::uint32_t n;
+		if(!in.read(reinterpret_cast<char*>(&n), sizeof(n))) {
+			if(in.eof() && in.gcount() == 0) {
+				return std::nullopt;
+			}
+			throw std::runtime_error("StringSerializer: truncated length");
+		}
+		std::string s(n, '\0');
+		if(!in.read(s.data(), std::streamsize(n))) {
+			throw std::runtime_error("StringSerializer: truncated string");
+		}
+		return s;
+	}
+};
+
+std::size_t filesIn(const fs::path& dir) {
+	return std::size_t(std::distance(fs::directory_iterator(dir), fs::directory_iterator()));
+}
+
+int main() {
+	const fs::path dir = fs::temp_directory_path() / "functional-cxx-external-sort-example";
+	fs::remove_all(dir);
+	fs::create_directories(dir);
+
+	std::mt19937 rng(37);
+	std::vector<std::uint32_t> data(1000000);
+	for(auto& x : data) {
+		x = rng();
+	}
+	std::vector<std::uint32_t> sorted(data);
+	std::sort(sorted.begin(), sorted.end());
+
+	{
+		// 64 KiB shared by two workers and the reader gives hundreds of runs, and a fan-in of 8 forces intermediate merge passes.
+		ExternalSortOptions options;
+		options.threads = 2;
+		options.fanIn = 8;
+		auto result = externalSort(streamOf(data), std::less<>(), 64 * 1024, dir, BinarySerializer<std::uint32_t>(), options);
+		std::size_t spilled = filesIn(dir);
+		check(spilled > 0 && spilled <= options.fanIn, "externalSort: spills runs, merged down to the fan-in");
+		check(toVector(std::move(result)) == sorted, "externalSort: sorted, out of core");
+		check(filesIn(dir) == 0, "externalSort: ...removing its files once read");
+	}
+
+	{
+		auto result = externalSort(streamOf(data), std::greater<>(), sizeof(std::uint32_t) * data.size() * 64, dir);
+		check(filesIn(dir) == 0, "externalSort: nothing is written when the input fits in memory");
+		check(toVector(std::move(result)) == std::vector<std::uint32_t>(sorted.rbegin(), sorted.rend()), "externalSort: ...and it is still sorted");
+	}
+
+	{
+		std::vector<std::string> words;
+		for(int i = 0; i < 20000; ++i) {
+			words.push_back(std::to_string(rng() % 100000) + std::string(rng() % 8, 'x'));
+		}
+		auto expected = words;
+		std::sort(expected.begin(), expected.end());
+		auto result = externalSort(streamOf(words), std::less<>(), 16 * sizeof(std::string) * 100, dir, StringSerializer());
+		check(filesIn(dir) > 0 && toVector(std::move(result)) == expected, "externalSort: with a custom serializer");
+	}
+
+	{
+		bool threw = false;
+		try {
+			externalSort(streamOf(data), std::less<>(), 64 * 1024, dir / "missing");
+		} catch(const std::runtime_error&) {
+			threw = true;
+		}
+		check(threw, "externalSort: failing to write a run throws std::runtime_error");
+	}
+
+	{
+		// A record cut short is an error, not the end of the data.
+		std::istringstream in(std::string(sizeof(std::uint32_t) + 2, 'x'));
+		BinarySerializer<std::uint32_t> serializer;
+		bool first = bool(serializer.read(in)), threw = false;
+		try {
+			serializer.read(in);
+		} catch(const std::runtime_error&) {
+			threw = true;
+		}
+		std::istringstream empty;
+		check(first && threw && !serializer.read(empty), "BinarySerializer: a truncated record throws, and only a clean end of file ends the data");
+	}
+
+	check(filesIn(dir) == 0, "externalSort: no files are left behind");
+	fs::remove_all(dir);
+	return checkStatus();
+}
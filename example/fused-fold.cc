@@ -0,0 +1,88 @@
+/************************************************************************************
+ *
+ * Author: Thomas Dickerson
+ * Copyright: 2021, Geopipe, Inc.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ************************************************************************************/
+
+
+#include <functional-cxx/stream.hpp>
+
+#include <numeric>
+#include <vector>
+
+#include "example-support.hpp"
+
+using namespace com::geopipe::functional;
+
+int main() {
+	std::vector<int> data(1000000);
+	std::iota(data.begin(), data.end(), 0);
+	long expected = 0;
+	for(int x : data) {
+		expected += 2L * x + 1;
+	}
+
+	std::size_t applied = 0;
+	auto mapped = streamOf(data)->map([&applied](int x){
+		++applied;
+		return 2L * x;
+	})->map([](long x){
+		return x + 1;
+	});
+	// Only the head has been mapped so far.
+	check(applied == 1, "Stream::map: maps the head eagerly, and the rest lazily");
+
+	check(fold(std::move(mapped), 0L, [](long a, long e){ return a + e; }) == expected, "fold: through two fused maps");
+	check(applied == data.size(), "fold: ...applies each transform once");
+	check(!mapped, "fold: ...consumes its Stream");
+
+	{
+		// Cells forced beforehand are memoized, and not mapped again.
+		applied = 0;
+		auto s = streamOf(data)->map([&applied](int x){
+			++applied;
+			return x;
+		});
+		{
+			auto cell = s;
+			for(int i = 0; i < 10; ++i) {
+				cell = cell->tail();
+			}
+		}
+		long sum = 0;
+		forEach(std::move(s), [&sum](int x){
+			sum += x;
+		});
+		check(sum == std::accumulate(data.begin(), data.end(), 0L), "forEach: over partly forced cells");
+		check(applied == data.size(), "forEach: ...only maps the cells not yet forced");
+	}
+
+	{
+		// A Stream still retained elsewhere is forced and memoized instead, so a later traversal maps nothing.
+		std::vector<int> small(data.begin(), data.begin() + 1000);
+		applied = 0;
+		auto s = streamOf(small)->map([&applied](int x){
+			++applied;
+			return x;
+		});
+		check(count(decltype(s)(s)) == small.size(), "count: over a retained Stream");
+		check(applied == small.size(), "count: ...maps each element once");
+		check(count(std::move(s)) == small.size(), "count: over memoized cells");
+		check(applied == small.size(), "count: ...without mapping them again");
+	}
+	return checkStatus();
+}
@@ -0,0 +1,105 @@
+/************************************************************************************
+ *
+ * Author: Thomas Dickerson
+ * Copyright: 2021, Geopipe, Inc.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ************************************************************************************/
+
+
+#include <functional-cxx/join.hpp>
+
+#include <algorithm>
+#include <random>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "example-support.hpp"
+
+using namespace com::geopipe::functional;
+
+/// An order: a customer id, and an amount.
+using Order = std::pair<int, int>;
+/// A customer: an id, and a name.
+using Customer = std::pair<int, std::string>;
+
+const auto orderKey = [](const Order& o){ return o.first; };
+const auto customerKey = [](const Customer& c){ return c.first; };
+
+/// The nested-loop join, in the order of `left`, then `right`, as an independent reference.
+std::vector<std::pair<Order, Customer>> nestedLoops(const std::vector<Order>& left, const std::vector<Customer>& right) {
+	std::vector<std::pair<Order, Customer>> result;
+	for(const Order& o : left) {
+		for(const Customer& c : right) {
+			if(o.first == c.first) {
+				result.emplace_back(o, c);
+			}
+		}
+	}
+	return result;
+}
+
+/// A `Stream` of the elements of `data`, counting how many are pulled.
+template<class E>
+std::shared_ptr<Stream<E>> counted(const std::vector<E>& data, std::size_t& pulled) {
+	return Stream<E>::Generate([&data, &pulled, i = std::size_t(0)]() mutable -> std::optional<E> {
+		return i < data.size() ? (++pulled, std::optional<E>(data[i++])) : std::nullopt;
+	});
+}
+
+int main() {
+	std::mt19937 rng(31);
+	std::vector<Order> orders(20000);
+	for(auto& o : orders) {
+		o = {int(rng() % 3000), int(rng() % 1000)};
+	}
+	std::vector<Customer> customers;
+	for(int id = 0; id < 2000; ++id) {
+		// Some customers have no orders, some orders have no customer, and some ids are duplicated.
+		customers.emplace_back(id, "customer " + std::to_string(id));
+		if(id % 50 == 0) {
+			customers.emplace_back(id, "duplicate " + std::to_string(id));
+		}
+	}
+
+	check(toVector(hashJoin(streamOf(orders), streamOf(customers), orderKey, customerKey)) == nestedLoops(orders, customers), "hashJoin: against nested loops");
+
+	{
+		std::vector<Order> sortedOrders(orders);
+		std::stable_sort(sortedOrders.begin(), sortedOrders.end(), [](const Order& a, const Order& b){ return a.first < b.first; });
+		check(toVector(mergeJoin(streamOf(sortedOrders), streamOf(customers), orderKey, customerKey)) == nestedLoops(sortedOrders, customers), "mergeJoin: against nested loops");
+
+		std::size_t left = 0, right = 0;
+		auto joined = mergeJoin(counted(sortedOrders, left), counted(customers, right), orderKey, customerKey);
+		check(joined->head().first.first == 0 && left < 20 && right < 5, "mergeJoin: forces each side no further than needed");
+		toVector(std::move(joined));
+		// Orders for ids past the last customer can match nothing, so are never forced.
+		check(right == customers.size() && left < sortedOrders.size(), "mergeJoin: ...even once the other side ends");
+	}
+
+	{
+		// The probe side is consumed lazily, so it may be unbounded.
+		auto forever = Stream<Order>::Generate([i = 0]() mutable -> std::optional<Order> {
+			return Order{i++ % 4000, 0};
+		});
+		auto joined = hashJoin(std::move(forever), streamOf(customers), orderKey, customerKey);
+		for(int i = 0; i < 10000; ++i) {
+			joined = joined->tail();
+		}
+		check(joined->head().first.first == joined->head().second.first, "hashJoin: an unbounded probe side");
+	}
+	return checkStatus();
+}
@@ -0,0 +1,64 @@
+/************************************************************************************
+ *
+ * Author: Thomas Dickerson
+ * Copyright: 2021, Geopipe, Inc.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ************************************************************************************/
+
+
+#include <functional-cxx/lazy-sort.hpp>
+
+#include <algorithm>
+#include <functional>
+#include <random>
+#include <vector>
+
+#include "example-support.hpp"
+
+using namespace com::geopipe::functional;
+
+int main() {
+	std::mt19937 rng(11);
+	std::vector<int> data(100000);
+	for(int& x : data) {
+		x = int(rng() % 5000); // Plenty of duplicates.
+	}
+	std::vector<int> sorted(data);
+	std::sort(sorted.begin(), sorted.end());
+
+	check(toVector(lazySorted(streamOf(data))) == sorted, "lazySorted: the whole output is sorted");
+
+	std::vector<int> descending(sorted.rbegin(), sorted.rend());
+	check(toVector(lazySorted(streamOf(data), std::greater<>())) == descending, "lazySorted: with a custom comparator");
+
+	{
+		// Taking only the first few elements should cost about O(n) comparisons, not O(n log n).
+		std::size_t comparisons = 0;
+		auto s = lazySorted(streamOf(data), [&comparisons](int a, int b){
+			++comparisons;
+			return a < b;
+		});
+		std::vector<int> first;
+		for(int i = 0; i < 10; ++i, s = s->tail()) {
+			first.push_back(s->head());
+		}
+		check(first == std::vector<int>(sorted.begin(), sorted.begin() + 10), "lazySorted: the first 10 elements");
+		check(comparisons < 4 * data.size(), "lazySorted: ...cost expected O(n) comparisons");
+	}
+
+	check(!lazySorted(Stream<int>::Nil()), "lazySorted: an empty Stream stays empty");
+	return checkStatus();
+}
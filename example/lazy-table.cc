@@ -0,0 +1,158 @@
+/************************************************************************************
+ *
+ * Author: Thomas Dickerson
+ * Copyright: 2021, Geopipe, Inc.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ************************************************************************************/
+
+
+#include <functional-cxx/lazy-table.hpp>
+
+#include <algorithm>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "example-support.hpp"
+
+using namespace com::geopipe::functional;
+
+/// Edit distance with two rolling rows, as an independent reference.
+std::size_t editDistance(const std::string& a, const std::string& b) {
+	std::vector<std::size_t> prev(b.size() + 1), next(b.size() + 1);
+	for(std::size_t j = 0; j <= b.size(); ++j) {
+		prev[j] = j;
+	}
+	for(std::size_t i = 1; i <= a.size(); ++i) {
+		next[0] = i;
+		for(std::size_t j = 1; j <= b.size(); ++j) {
+			next[j] = std::min({prev[j] + 1, next[j - 1] + 1, prev[j - 1] + (a[i - 1] != b[j - 1])});
+		}
+		std::swap(prev, next);
+	}
+	return prev[b.size()];
+}
+
+std::string randomString(std::mt19937& rng, std::size_t n) {
+	std::string s(n, 'a');
+	for(char& c : s) {
+		c = char('a' + rng() % 4);
+	}
+	return s;
+}
+
+int main() {
+	std::mt19937 rng(3);
+	const std::string a = randomString(rng, 700), b = randomString(rng, 500);
+	const std::size_t expected = editDistance(a, b);
+	auto distance = [&](auto& d, std::size_t i, std::size_t j) -> std::size_t {
+		if(!i || !j) {
+			return i + j;
+		}
+		return std::min({d(i - 1, j) + 1, d(i, j - 1) + 1, d(i - 1, j - 1) + (a[i - 1] != b[j - 1])});
+	};
+	TableOptions parallel;
+	parallel.tileSize = 32;
+	parallel.threads = 4;
+
+	{
+		auto d = lazyTable<std::size_t>(a.size() + 1, b.size() + 1, distance);
+		check(d(a.size(), b.size()) == expected, "LazyTable: edit distance, on demand");
+	}
+
+	{
+		auto d = lazyTable<std::size_t>(a.size() + 1, b.size() + 1, distance, parallel);
+		d.evaluate();
+		bool all = true;
+		for(std::size_t i = 0; i <= a.size(); ++i) {
+			for(std::size_t j = 0; j <= b.size(); ++j) {
+				all &= d.forced(i, j);
+			}
+		}
+		check(all && d(a.size(), b.size()) == expected, "LazyTable: edit distance, evaluated in parallel tiles");
+		check(d(300, 200) == editDistance(a.substr(0, 300), b.substr(0, 200)), "LazyTable: ...every cell is right");
+	}
+
+	{
+		// Forcing part of the table first, then evaluating the rest.
+		auto d = lazyTable<std::size_t>(a.size() + 1, b.size() + 1, distance, parallel);
+		d(123, 456);
+		d.evaluate();
+		check(d(a.size(), b.size()) == expected, "LazyTable: on demand and evaluate may be mixed");
+	}
+
+	{
+		// The distance from the top or left edge along a diagonal only depends on (i - 1, j - 1), so forcing one cell forces a diagonal.
+		auto diagonal = lazyTable<std::size_t>(a.size() + 1, b.size() + 1, [](auto& d, std::size_t i, std::size_t j) -> std::size_t {
+			return i && j ? d(i - 1, j - 1) + 1 : 0;
+		});
+		diagonal(a.size(), b.size());
+		std::size_t n = 0;
+		for(std::size_t i = 0; i <= a.size(); ++i) {
+			for(std::size_t j = 0; j <= b.size(); ++j) {
+				n += diagonal.forced(i, j);
+			}
+		}
+		check(n == b.size() + 1 && diagonal.forced(a.size() - b.size(), 0), "LazyTable: on demand only forces dependencies");
+	}
+
+	{
+		// A dependency chain far deeper than maxNativeDepth.
+		auto prefix = lazyTable<std::uint64_t>(1, 200000, [](auto& p, std::size_t, std::size_t j) -> std::uint64_t {
+			return j ? p(0, j - 1) + j : 0;
+		});
+		check(prefix(0, 199999) == 199999ull * 200000 / 2, "LazyTable: deep chains on demand");
+	}
+
+	{
+		auto bad = lazyTable<int>(64, 64, [](auto& t, std::size_t i, std::size_t j) -> int {
+			return i && j + 1 < t.cols() ? t(i - 1, j + 1) : 0;
+		}, parallel);
+		bool threw = false;
+		try {
+			bad.evaluate();
+		} catch(const std::logic_error&) {
+			threw = true;
+		}
+		check(threw, "LazyTable::evaluate: depending on the upper right throws std::logic_error");
+
+		bool outOfRange = false;
+		try {
+			bad(64, 0);
+		} catch(const std::out_of_range&) {
+			outOfRange = true;
+		}
+		check(outOfRange, "LazyTable: a cell outside the table throws std::out_of_range");
+	}
+
+	{
+		auto failing = lazyTable<int>(256, 256, [](auto&, std::size_t i, std::size_t j) -> int {
+			if(i == 200 && j == 100) {
+				throw std::runtime_error("failed");
+			}
+			return 0;
+		}, parallel);
+		bool threw = false;
+		try {
+			failing.evaluate();
+		} catch(const std::runtime_error&) {
+			threw = true;
+		}
+		check(threw, "LazyTable::evaluate: an exception from the recurrence is rethrown");
+	}
+	return checkStatus();
+}
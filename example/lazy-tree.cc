@@ -0,0 +1,121 @@
+/************************************************************************************
+ *
+ * Author: Thomas Dickerson
+ * Copyright: 2021, Geopipe, Inc.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ************************************************************************************/
+
+
+#include <functional-cxx/lazy-tree.hpp>
+
+#include <cstddef>
+#include <vector>
+
+#include "example-support.hpp"
+
+using namespace com::geopipe::functional;
+
+using Tree = LazyTree<int>;
+
+/// The labels (and depths) a traversal visits.
+template<class S>
+std::vector<std::pair<int, std::size_t>> labels(S stream) {
+	std::vector<std::pair<int, std::size_t>> result;
+	for(; stream; stream = stream->tail()) {
+		result.emplace_back(stream->head().node->head(), stream->head().depth);
+	}
+	return result;
+}
+
+void preorder(int label, std::size_t depth, std::vector<std::pair<int, std::size_t>>& out) {
+	out.emplace_back(label, depth);
+	if(2 * label < 64) {
+		preorder(2 * label, depth + 1, out);
+		preorder(2 * label + 1, depth + 1, out);
+	}
+}
+
+int main() {
+	// A complete binary tree labelled in heap order: 1, then 2 and 3, ..., up to 63.
+	std::size_t expansions = 0;
+	auto binary = [&expansions](int n){
+		++expansions;
+		return 2 * n < 64 ? streamOf(std::vector<int>{2 * n, 2 * n + 1}) : Stream<int>::Nil();
+	};
+
+	std::vector<std::pair<int, std::size_t>> levels, pre;
+	for(int n = 1; n < 64; ++n) {
+		std::size_t depth = 0;
+		for(int m = n; m > 1; m /= 2) {
+			++depth;
+		}
+		levels.emplace_back(n, depth);
+	}
+	preorder(1, 0, pre);
+
+	check(labels(depthFirst<int>(Tree::Unfold(1, binary))) == pre, "depthFirst: preorder");
+	check(labels(breadthFirst<int>(Tree::Unfold(1, binary))) == levels, "breadthFirst: level order");
+
+	{
+		Tree::TreeT root = Tree::Unfold(1, binary);
+		expansions = 0;
+		check(labels(iterativeDeepening<int>(root)) == levels, "iterativeDeepening: level order");
+		check(expansions == 63, "iterativeDeepening: children are memoized across rounds");
+	}
+
+	{
+		// Pruning at 2 skips its whole subtree without expanding it.
+		expansions = 0;
+		auto visited = labels(depthFirst<int>(Tree::Unfold(1, binary), [](int n, std::size_t){ return n == 2; }));
+		bool skipped = true;
+		for(auto [n, depth] : visited) {
+			for(int m = n; m > 1; m /= 2) {
+				skipped &= m != 4 && m != 5;
+			}
+		}
+		check(skipped && visited.size() == 33, "depthFirst: a pruned subtree is not visited");
+		check(expansions == 63 - 31, "depthFirst: ...nor expanded");
+	}
+
+	{
+		// An infinite tree is only expanded as far as it is traversed.
+		expansions = 0;
+		auto s = breadthFirst<int>(Tree::Unfold(1, [&expansions](int n){
+			++expansions;
+			return streamOf(std::vector<int>{2 * n, 2 * n + 1});
+		}));
+		for(int i = 0; i < 10; ++i) {
+			s = s->tail();
+		}
+		check(s->head().node->head() == 11, "breadthFirst: an infinite tree");
+		check(expansions == 10, "breadthFirst: ...only expanding the nodes emitted before it");
+	}
+
+	{
+		// Dropping a fully forced, very deep tree must not overflow the stack.
+		const int depth = 1000000;
+		Tree::TreeT chain = Tree::Unfold(0, [](int n){
+			return n < depth ? streamOf(std::vector<int>{n + 1}) : Stream<int>::Nil();
+		});
+		std::size_t count = 0;
+		for(auto s = depthFirst<int>(chain); s; s = s->tail()) {
+			++count;
+		}
+		chain.reset();
+		check(count == depth + 1, "LazyTree: a deep tree is traversed, and released, iteratively");
+	}
+	return checkStatus();
+}
@@ -0,0 +1,117 @@
+/************************************************************************************
+ *
+ * Author: Thomas Dickerson
+ * Copyright: 2021, Geopipe, Inc.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ************************************************************************************/
+
+
+#include <functional-cxx/memoize.hpp>
+
+#include <atomic>
+#include <cstdint>
+#include <thread>
+#include <vector>
+
+#include "example-support.hpp"
+
+using namespace com::geopipe::functional;
+
+int main() {
+	{
+		std::size_t calls = 0;
+		auto fib = memoize<std::uint64_t(unsigned)>([&calls](auto& fib, unsigned n) -> std::uint64_t {
+			++calls;
+			return n < 2 ? n : fib(n - 1) + fib(n - 2);
+		});
+		std::uint64_t a = 0, b = 1;
+		for(int i = 0; i < 90; ++i) {
+			b += a;
+			a = b - a;
+		}
+		check(fib(90) == a, "memoize: fib(90)");
+		check(calls == 91 && fib.size() == 91, "memoize: ...computes each result once");
+	}
+
+	{
+		// Multiple arguments are memoized as a tuple.
+		auto choose = memoize<std::uint64_t(unsigned, unsigned)>([](auto& choose, unsigned n, unsigned k) -> std::uint64_t {
+			return k == 0 || k == n ? 1 : choose(n - 1, k - 1) + choose(n - 1, k);
+		});
+		check(choose(60, 30) == 118264581564861424ull, "memoize: choose(60, 30)");
+	}
+
+	{
+		// Recursion a million deep, on bounded native stack, in linear time.
+		std::size_t calls = 0;
+		auto sum = memoize<std::uint64_t(std::uint64_t)>([&calls](auto& sum, std::uint64_t n) -> std::uint64_t {
+			++calls;
+			return n == 0 ? 0 : n + sum(n - 1);
+		});
+		const std::uint64_t n = 1000000;
+		check(sum(n) == n * (n + 1) / 2, "memoize: recursion deeper than maxNativeDepth");
+		check(calls < 3 * n, "memoize: ...with linear work");
+	}
+
+	{
+		MemoOptions bounded;
+		bounded.capacity = 16;
+		auto fib = memoize<std::uint64_t(unsigned)>([](auto& fib, unsigned n) -> std::uint64_t {
+			return n < 2 ? n : fib(n - 1) + fib(n - 2);
+		}, bounded);
+		bool small = true;
+		std::uint64_t a = 0, b = 1;
+		bool right = true;
+		for(unsigned i = 0; i < 90; ++i) {
+			right &= fib(i) == a;
+			small &= fib.size() <= 16;
+			b += a;
+			a = b - a;
+		}
+		check(right, "memoize: with a bounded cache");
+		check(small, "memoize: ...which stays within its capacity");
+	}
+
+	{
+		// Collatz stopping times, from several threads sharing one cache.
+		auto steps = concurrentMemoize<std::uint32_t(std::uint64_t)>([](auto& steps, std::uint64_t n) -> std::uint32_t {
+			return n == 1 ? 0 : 1 + steps(n % 2 ? 3 * n + 1 : n / 2);
+		});
+		const std::uint64_t n = 50000;
+		std::vector<std::uint32_t> expected(n);
+		for(std::uint64_t i = 1; i < n; ++i) {
+			for(std::uint64_t m = i; m != 1; m = m % 2 ? 3 * m + 1 : m / 2) {
+				++expected[i];
+			}
+		}
+		std::atomic<bool> right{true};
+		std::vector<std::thread> pool;
+		for(std::uint64_t t = 0; t < 4; ++t) {
+			pool.emplace_back([&, t](){
+				for(std::uint64_t i = 1 + t; i < n; i += 4) {
+					if(steps(i) != expected[i]) {
+						right = false;
+					}
+				}
+			});
+		}
+		for(auto& t : pool) {
+			t.join();
+		}
+		check(right, "concurrentMemoize: shared between threads");
+	}
+	return checkStatus();
+}
@@ -0,0 +1,106 @@
+/************************************************************************************
+ *
+ * Author: Thomas Dickerson
+ * Copyright: 2021, Geopipe, Inc.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ************************************************************************************/
+
+
+#include <functional-cxx/merge-sorted.hpp>
+
+#include <algorithm>
+#include <random>
+#include <utility>
+#include <vector>
+
+#include "example-support.hpp"
+
+using namespace com::geopipe::functional;
+
+using Tagged = std::pair<int, std::size_t>; ///< A key, and the index of the input it came from.
+
+struct ByKey {
+	bool operator()(const Tagged& a, const Tagged& b) const {
+		return a.first < b.first;
+	}
+};
+
+int main() {
+	std::mt19937 rng(7);
+	const std::size_t k = 13;
+
+	// Sorted inputs of various lengths (some empty), with many duplicate keys across inputs.
+	std::vector<std::vector<Tagged>> inputs(k);
+	std::vector<Tagged> expected;
+	for(std::size_t i = 0; i < k; ++i) {
+		std::size_t length = i % 4 == 3 ? 0 : rng() % 500;
+		for(std::size_t j = 0; j < length; ++j) {
+			inputs[i].emplace_back(int(rng() % 100), i);
+		}
+		std::sort(inputs[i].begin(), inputs[i].end());
+		expected.insert(expected.end(), inputs[i].begin(), inputs[i].end());
+	}
+	std::stable_sort(expected.begin(), expected.end(), ByKey());
+
+	{
+		std::vector<std::shared_ptr<Stream<Tagged>>> streams;
+		for(auto& input : inputs) {
+			streams.push_back(streamOf(input));
+		}
+		check(toVector(mergeSorted(std::move(streams), ByKey())) == expected, "mergeSorted: sorted, and stable with respect to the order of the inputs");
+	}
+
+	{
+		// Forcing the first few outputs only forces the inputs that supplied them.
+		std::size_t forced = 0;
+		std::vector<std::shared_ptr<Stream<int>>> streams;
+		for(std::size_t i = 0; i < k; ++i) {
+			streams.push_back(Stream<int>::Generate([&forced, i, next = int(i)]() mutable -> std::optional<int> {
+				++forced;
+				return (next += int(k)) < 100000 ? std::optional<int>(next) : std::nullopt;
+			}));
+		}
+		auto merged = mergeSorted(std::move(streams));
+		std::size_t initial = forced;
+		for(int i = 0; i < 20; ++i) {
+			merged = merged->tail();
+		}
+		check(initial == k && forced == k + 20 && merged->head() == int(k + 20), "mergeSorted: each output forces exactly one input tail");
+	}
+
+	{
+		std::vector<std::shared_ptr<Stream<std::vector<Tagged>>>> streams;
+		for(auto& input : inputs) {
+			// Chunks of varying size, including empty ones.
+			std::vector<std::vector<Tagged>> chunks(1);
+			for(const Tagged& t : input) {
+				if(rng() % 8 == 0) {
+					chunks.emplace_back();
+				}
+				chunks.back().push_back(t);
+			}
+			streams.push_back(streamOf(chunks));
+		}
+		std::vector<Tagged> merged;
+		bool bounded = true;
+		for(auto s = mergeSortedChunks(std::move(streams), ByKey(), 64); s; s = s->tail()) {
+			bounded &= !s->head().empty() && s->head().size() <= 64;
+			merged.insert(merged.end(), s->head().begin(), s->head().end());
+		}
+		check(merged == expected && bounded, "mergeSortedChunks: the same order, in non-empty chunks of at most chunkSize");
+	}
+	return checkStatus();
+}
@@ -0,0 +1,88 @@
+/************************************************************************************
+ *
+ * Author: Thomas Dickerson
+ * Copyright: 2021, Geopipe, Inc.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ************************************************************************************/
+
+
+#include <functional-cxx/multicast.hpp>
+
+#include <algorithm>
+#include <numeric>
+#include <thread>
+#include <vector>
+
+#include "example-support.hpp"
+
+using namespace com::geopipe::functional;
+
+/// Pull everything from `cursor`, checking after each pull that nobody is more than `bound` ahead.
+std::vector<int> drain(Multicast<int>& hub, Multicast<int>::Cursor cursor, std::size_t bound, bool& bounded) {
+	std::vector<int> seen;
+	while(auto cell = cursor.pull()) {
+		seen.push_back(cell->head());
+		bounded &= hub.stats().maxLag <= bound;
+	}
+	return seen;
+}
+
+int main() {
+	std::vector<int> data(10000);
+	std::iota(data.begin(), data.end(), 0);
+
+	{
+		// Two consumers on different threads, with backpressure.
+		Multicast<int> hub(streamOf(data), LagPolicy::Block, 16);
+		auto a = hub.subscribe();
+		auto b = hub.subscribe();
+		bool boundedA = true, boundedB = true;
+		std::vector<int> seenB;
+		std::thread other([&](){
+			seenB = drain(hub, std::move(b), 16, boundedB);
+		});
+		std::vector<int> seenA = drain(hub, std::move(a), 16, boundedA);
+		other.join();
+		check(seenA == data && seenB == data, "Block: every cursor sees every element, in order");
+		check(boundedA && boundedB, "Block: no cursor gets more than `bound` ahead");
+	}
+
+	{
+		// A slow consumer is skipped forward rather than holding everyone up.
+		Multicast<int> hub(streamOf(data), LagPolicy::DropOldest, 8);
+		auto fast = hub.subscribe();
+		auto slow = hub.subscribe();
+		for(int i = 0; i < 100; ++i) {
+			fast.pull();
+		}
+		check(slow.lag() <= 8 && slow.dropped() == 92, "DropOldest: the slow cursor lags by at most `bound`, and counts what it missed");
+		auto next = slow.pull();
+		check(next && next->head() == 92, "DropOldest: the slow cursor resumes at the oldest retained element");
+	}
+
+	{
+		// Late subscribers start at the slowest live cursor.
+		Multicast<int> hub(streamOf(data));
+		auto first = hub.subscribe();
+		for(int i = 0; i < 10; ++i) {
+			first.pull();
+		}
+		auto second = hub.subscribe();
+		auto cell = second.pull();
+		check(cell && cell->head() == 10 && hub.stats().cursors == 2, "subscribe starts where the slowest cursor is");
+	}
+	return checkStatus();
+}
@@ -0,0 +1,130 @@
+/************************************************************************************
+ *
+ * Author: Thomas Dickerson
+ * Copyright: 2021, Geopipe, Inc.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ************************************************************************************/
+
+
+#include <functional-cxx/parallel-search.hpp>
+
+#include <atomic>
+#include <climits>
+#include <cstdint>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+#include "example-support.hpp"
+
+using namespace com::geopipe::functional;
+
+constexpr int kNodes = 1 << 16; ///< Labels of a complete binary tree in heap order are 1 .. kNodes - 1.
+
+LazyTree<int>::TreeT binaryTree() {
+	return LazyTree<int>::Unfold(1, [](int n){
+		return 2 * n < kNodes ? streamOf(std::vector<int>{2 * n, 2 * n + 1}) : Stream<int>::Nil();
+	});
+}
+
+/// A node of a branch-and-bound search: its label, and the cost of the path to it.
+using Partial = std::pair<int, int>;
+
+int edgeCost(int n) {
+	return int((std::uint32_t(n) * 2654435761u) >> 24) % 97;
+}
+
+/// The cheapest root-to-leaf path, by exhaustive recursion, as an independent reference.
+int cheapest(int n, int cost) {
+	if(2 * n >= kNodes) {
+		return cost;
+	}
+	return std::min(cheapest(2 * n, cost + edgeCost(2 * n)), cheapest(2 * n + 1, cost + edgeCost(2 * n + 1)));
+}
+
+int main() {
+	const ParallelSearchOptions four{4};
+	{
+		std::vector<std::atomic<int>> visits(kNodes);
+		std::atomic<bool> parentFirst{true};
+		std::size_t n = parallelDepthFirst<int>(binaryTree(), [&](const Visit<int>& v){
+			int label = v.node->head();
+			if(label > 1 && !visits[label / 2].load(std::memory_order_relaxed)) {
+				parentFirst = false;
+			}
+			visits[label].fetch_add(1, std::memory_order_relaxed);
+		}, NoPrune(), four);
+		bool once = true;
+		for(int i = 1; i < kNodes; ++i) {
+			once &= visits[i] == 1;
+		}
+		check(n == kNodes - 1 && once, "parallelDepthFirst: every node is visited exactly once");
+		check(parentFirst, "parallelDepthFirst: ...after its parent");
+	}
+
+	{
+		std::atomic<bool> found{false};
+		std::size_t n = parallelDepthFirst<int>(binaryTree(), [&](const Visit<int>& v){
+			if(v.node->head() == 3) {
+				found = true;
+				return false;
+			}
+			return true;
+		}, NoPrune(), four);
+		check(found && n < kNodes - 1, "parallelDepthFirst: the visitor can stop the search early");
+	}
+
+	{
+		// Branch-and-bound for the cheapest root-to-leaf path.
+		auto tree = LazyTree<Partial>::Unfold(Partial{1, 0}, [](const Partial& p){
+			auto [n, cost] = p;
+			return 2 * n < kNodes ? streamOf(std::vector<Partial>{{2 * n, cost + edgeCost(2 * n)}, {2 * n + 1, cost + edgeCost(2 * n + 1)}}) : Stream<Partial>::Nil();
+		});
+		SharedBound<int> best(INT_MAX);
+		std::size_t n = parallelDepthFirst<Partial>(tree, [&](const Visit<Partial>& v){
+			if(2 * v.node->head().first >= kNodes) {
+				best.improve(v.node->head().second);
+			}
+		}, [&](const Partial& p, std::size_t){
+			return p.second >= best.get();
+		}, four);
+		check(best.get() == cheapest(1, 0), "parallelDepthFirst: branch-and-bound finds the cheapest path");
+		check(n < kNodes - 1, "parallelDepthFirst: ...without visiting the whole tree");
+	}
+
+	{
+		bool threw = false;
+		try {
+			parallelDepthFirst<int>(binaryTree(), [](const Visit<int>& v){
+				if(v.node->head() == 1000) {
+					throw std::runtime_error("found");
+				}
+			}, NoPrune(), four);
+		} catch(const std::runtime_error&) {
+			threw = true;
+		}
+		check(threw, "parallelDepthFirst: an exception from the visitor is rethrown");
+	}
+
+	{
+		// A chain gives the other workers nothing to steal: they should wait, then finish with it.
+		auto chain = LazyTree<int>::Unfold(0, [](int n){
+			return n < 100000 ? streamOf(std::vector<int>{n + 1}) : Stream<int>::Nil();
+		});
+		check(parallelDepthFirst<int>(chain, [](const Visit<int>&){}, NoPrune(), four) == 100001, "parallelDepthFirst: a chain");
+	}
+	return checkStatus();
+}
@@ -0,0 +1,84 @@
+/************************************************************************************
+ *
+ * Author: Thomas Dickerson
+ * Copyright: 2021, Geopipe, Inc.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ************************************************************************************/
+
+
+#include <functional-cxx/partition.hpp>
+
+#include <algorithm>
+#include <functional>
+#include <numeric>
+#include <thread>
+#include <vector>
+
+#include "example-support.hpp"
+
+using namespace com::geopipe::functional;
+
+int main() {
+	const std::size_t n = 4;
+	std::vector<int> data(100000);
+	std::iota(data.begin(), data.end(), 0);
+
+	{
+		// Shard by key, and consume each shard on its own thread.
+		auto key = [](int e){ return e / 10; };
+		auto shards = partition(streamOf(data), n, key, 64);
+		std::vector<std::vector<int>> seen(n);
+		std::vector<std::thread> consumers;
+		for(std::size_t k = 0; k < n; ++k) {
+			consumers.emplace_back([&seen, k, shard = std::move(shards[k])]() mutable {
+				// Forcing the shard here, on its consumer's thread.
+				seen[k] = toVector(std::shared_ptr<Stream<int>>(std::move(shard)));
+			});
+		}
+		for(auto& t : consumers) {
+			t.join();
+		}
+		bool routed = true, ordered = true;
+		std::vector<int> all;
+		for(std::size_t k = 0; k < n; ++k) {
+			for(int e : seen[k]) {
+				routed &= std::hash<int>()(key(e)) % n == k;
+			}
+			ordered &= std::is_sorted(seen[k].begin(), seen[k].end());
+			all.insert(all.end(), seen[k].begin(), seen[k].end());
+		}
+		std::sort(all.begin(), all.end());
+		check(all == data, "partition: the shards together hold every element exactly once");
+		check(routed, "partition: equal keys always go to the same shard");
+		check(ordered, "partition: each shard preserves the source order");
+	}
+
+	{
+		// Round-robin, consumed one after the other: earlier shards buffer what the later ones need.
+		auto shards = partitionRoundRobin(streamOf(std::vector<int>(data.begin(), data.begin() + 1001)), n, 7);
+		bool dealt = true;
+		std::size_t total = 0;
+		for(std::size_t k = 0; k < n; ++k) {
+			std::vector<int> shard = toVector(std::shared_ptr<Stream<int>>(std::move(shards[k])));
+			for(std::size_t i = 0; i < shard.size(); ++i) {
+				dealt &= shard[i] == int(i * n + k);
+			}
+			total += shard.size();
+		}
+		check(dealt && total == 1001, "partitionRoundRobin: shard k holds elements k, k + n, k + 2n, ...");
+	}
+	return checkStatus();
+}
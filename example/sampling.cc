@@ -0,0 +1,114 @@
+/************************************************************************************
+ *
+ * Author: Thomas Dickerson
+ * Copyright: 2021, Geopipe, Inc.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ************************************************************************************/
+
+
+#include <functional-cxx/sampling.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+#include <random>
+#include <stdexcept>
+#include <vector>
+
+#include "example-support.hpp"
+
+using namespace com::geopipe::functional;
+
+/// A generator which counts how many numbers are drawn from it.
+struct CountingRng {
+	using result_type = std::mt19937_64::result_type;
+	std::mt19937_64 rng;
+	std::size_t draws = 0;
+
+	static constexpr result_type min() {
+		return std::mt19937_64::min();
+	}
+
+	static constexpr result_type max() {
+		return std::mt19937_64::max();
+	}
+
+	result_type operator()() {
+		++draws;
+		return rng();
+	}
+};
+
+int main() {
+	std::mt19937_64 rng(23);
+	std::vector<int> data(100);
+	std::iota(data.begin(), data.end(), 0);
+
+	{
+		const int trials = 20000;
+		std::vector<int> hits(data.size());
+		bool valid = true;
+		for(int t = 0; t < trials; ++t) {
+			std::vector<int> sample = reservoirSample(streamOf(data), 10, rng);
+			std::sort(sample.begin(), sample.end());
+			valid &= sample.size() == 10 && std::adjacent_find(sample.begin(), sample.end()) == sample.end();
+			for(int x : sample) {
+				++hits[x];
+			}
+		}
+		double worst = 0;
+		for(int h : hits) {
+			worst = std::max(worst, std::abs(double(h) / trials - 0.1));
+		}
+		check(valid, "reservoirSample: k distinct elements of the source");
+		check(worst < 0.012, "reservoirSample: ...each included with probability k / n");
+		check(reservoirSample(streamOf(std::vector<int>{1, 2, 3}), 10, rng).size() == 3, "reservoirSample: all of a short source");
+		check(reservoirSample(streamOf(data), 0, rng).empty(), "reservoirSample: k = 0");
+	}
+
+	{
+		CountingRng counting{std::mt19937_64(5)};
+		std::vector<int> big(1000000);
+		std::iota(big.begin(), big.end(), 0);
+		check(reservoirSample(streamOf(big), 100, counting).size() == 100 && counting.draws < 5000, "reservoirSample: draws O(k log(n / k)) random numbers");
+	}
+
+	{
+		// Weights 0, 1, 2, 3, 4: element i should be drawn alone with probability i / 10, and 0 never.
+		const int trials = 40000;
+		std::vector<int> hits(5);
+		for(int t = 0; t < trials; ++t) {
+			for(int x : weightedSample(streamOf(std::vector<int>{0, 1, 2, 3, 4}), 1, [](int x){ return double(x); }, rng)) {
+				++hits[x];
+			}
+		}
+		bool proportional = hits[0] == 0;
+		for(int i = 1; i < 5; ++i) {
+			proportional &= std::abs(double(hits[i]) / trials - i / 10.0) < 0.012;
+		}
+		check(proportional, "weightedSample: drawn in proportion to weight, and never with zero weight");
+		check(weightedSample(streamOf(std::vector<int>{0, 1, 2}), 5, [](int x){ return double(x); }, rng).size() == 2, "weightedSample: all positively weighted elements of a short source");
+
+		bool threw = false;
+		try {
+			weightedSample(streamOf(std::vector<int>{1, -1}), 1, [](int x){ return double(x); }, rng);
+		} catch(const std::invalid_argument&) {
+			threw = true;
+		}
+		check(threw, "weightedSample: a negative weight throws std::invalid_argument");
+	}
+	return checkStatus();
+}
@@ -0,0 +1,140 @@
+/************************************************************************************
+ *
+ * Author: Thomas Dickerson
+ * Copyright: 2021, Geopipe, Inc.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ************************************************************************************/
+
+
+#include <functional-cxx/sketch.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <random>
+#include <stdexcept>
+#include <unordered_map>
+#include <vector>
+
+#include "example-support.hpp"
+
+using namespace com::geopipe::functional;
+
+int main() {
+	std::mt19937_64 rng(21);
+	// A million elements drawn from 200000 distinct values, with a skewed distribution.
+	std::vector<std::uint64_t> data(1000000);
+	std::unordered_map<std::uint64_t, std::uint64_t> counts;
+	for(auto& x : data) {
+		x = rng() % 200000;
+		x = x % 7 ? x : x % 100;
+		++counts[x];
+	}
+	const auto half = data.begin() + data.size() / 2;
+
+	{
+		auto whole = sketch(streamOf(data), HyperLogLog<std::uint64_t>());
+		double error = std::abs(whole.estimate() / double(counts.size()) - 1);
+		check(error < 0.03, "HyperLogLog: the distinct count, to within 3%");
+
+		HyperLogLog<std::uint64_t> a, b;
+		a.addBatch(data.begin(), half);
+		b.addBatch(half, data.end());
+		a.merge(b);
+		check(a.estimate() == whole.estimate(), "HyperLogLog: merging shards is exact");
+
+		bool threw = false;
+		try {
+			a.merge(HyperLogLog<std::uint64_t>(10));
+		} catch(const std::invalid_argument&) {
+			threw = true;
+		}
+		check(threw, "HyperLogLog: merging a different precision throws std::invalid_argument");
+	}
+
+	{
+		const double epsilon = 0.0005;
+		auto cms = sketchChunks(streamOf(std::vector<std::vector<std::uint64_t>>{std::vector<std::uint64_t>(data.begin(), half), std::vector<std::uint64_t>(half, data.end())}),
+		                        CountMinSketch<std::uint64_t>::withError(epsilon, 0.01));
+		bool never = true;
+		std::size_t within = 0;
+		for(const auto& [key, count] : counts) {
+			std::uint64_t e = cms.estimate(key);
+			never &= e >= count;
+			within += double(e - count) <= epsilon * double(cms.total());
+		}
+		check(cms.total() == data.size() && never, "CountMinSketch: never undercounts");
+		check(within >= 0.99 * double(counts.size()), "CountMinSketch: ...and overcounts by at most epsilon * total, with probability 1 - delta");
+
+		auto a = CountMinSketch<std::uint64_t>::withError(epsilon, 0.01), b = a;
+		for(auto it = data.begin(); it != half; ++it) {
+			a.add(*it);
+		}
+		b.addBatch(half, data.end());
+		a.merge(b);
+		bool same = true;
+		for(const auto& kv : counts) {
+			same &= a.estimate(kv.first) == cms.estimate(kv.first);
+		}
+		check(same, "CountMinSketch: merging shards is exact");
+	}
+
+	{
+		std::uniform_real_distribution<double> uniform;
+		std::vector<double> values(200000);
+		for(double& v : values) {
+			v = uniform(rng);
+		}
+		std::vector<TDigest> shards(4, TDigest(100));
+		for(std::size_t i = 0; i < values.size(); ++i) {
+			shards[i % 4].add(values[i]);
+		}
+		TDigest digest(100);
+		for(const auto& shard : shards) {
+			digest.merge(shard);
+		}
+		std::sort(values.begin(), values.end());
+		auto exact = [&](double q){
+			return values[std::size_t(q * double(values.size() - 1))];
+		};
+		check(digest.count() == double(values.size()) && digest.min() == values.front() && digest.max() == values.back(), "TDigest: count and extremes");
+		check(std::abs(digest.quantile(0.5) - exact(0.5)) < 0.01, "TDigest: the median, from merged shards");
+		check(std::abs(digest.quantile(0.999) - exact(0.999)) < 0.001, "TDigest: ...and a tail quantile, more precisely");
+		check(digest.size() < 200, "TDigest: in memory proportional to the compression");
+	}
+
+	{
+		ScalableBloomFilter<std::uint64_t> bloom(1000, 0.001);
+		bool fresh = true;
+		for(std::uint64_t i = 0; i < 100000; ++i) {
+			fresh &= bloom.insert(2 * i);
+		}
+		bool none = true;
+		std::size_t falsePositives = 0;
+		for(std::uint64_t i = 0; i < 100000; ++i) {
+			none &= bloom.contains(2 * i);
+			falsePositives += bloom.contains(2 * i + 1);
+		}
+		check(none && !bloom.insert(0), "ScalableBloomFilter: no false negatives, growing from a small capacity");
+		check(falsePositives < 100, "ScalableBloomFilter: false positive rate below the target");
+	}
+
+	{
+		auto snapshots = toVector(sketchScan(streamOf(std::vector<int>{1, 2, 3, 1, 2, 3, 4, 5, 6, 7}), HyperLogLog<int>(), 4));
+		check(snapshots.size() == 3 && std::round(snapshots[0].estimate()) == 3 && std::round(snapshots[2].estimate()) == 7, "sketchScan: a snapshot per interval");
+	}
+	return checkStatus();
+}
@@ -0,0 +1,115 @@
+/************************************************************************************
+ *
+ * Author: Thomas Dickerson
+ * Copyright: 2021, Geopipe, Inc.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ************************************************************************************/
+
+
+#include <functional-cxx/spilling-stream.hpp>
+
+#include <cstdint>
+#include <filesystem>
+#include <numeric>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "example-support.hpp"
+
+using namespace com::geopipe::functional;
+namespace fs = std::filesystem;
+
+/// Length-prefixed strings.
+struct StringSerializer {
+	void write(std::ostream& out, const std::string& s) const {
+		std::uint32_t n = std::uint32_t(s.size());
+		out.write(reinterpret_cast<const char*>(&n), sizeof(n));
+		out.write(s.data(), std::streamsize(n));
+	}
+
+	std::optional<std::string> read(std::istream& in) const {
+		std::uint32_t n;
+		if(!in.read(reinterpret_cast<char*>(&n), sizeof(n))) {
+			if(in.eof() && in.gcount() == 0) {
+				return std::nullopt;
+			}
+			throw std::runtime_error("StringSerializer: truncated length");
+		}
+		std::string s(n, '\0');
+		if(!in.read(s.data(), std::streamsize(n))) {
+			throw std::runtime_error("StringSerializer: truncated string");
+		}
+		return s;
+	}
+};
+
+std::size_t filesIn(const fs::path& dir) {
+	return std::size_t(std::distance(fs::directory_iterator(dir), fs::directory_iterator()));
+}
+
+int main() {
+	const fs::path dir = fs::temp_directory_path() / "functional-cxx-spilling-stream-example";
+	fs::remove_all(dir);
+	fs::create_directories(dir);
+
+	std::vector<int> data(200000);
+	std::iota(data.begin(), data.end(), 0);
+
+	{
+		std::size_t pulled = 0;
+		auto source = Stream<int>::Generate([&data, &pulled, i = std::size_t(0)]() mutable -> std::optional<int> {
+			return i < data.size() ? (++pulled, std::optional<int>(data[i++])) : std::nullopt;
+		});
+		auto spilling = spillingStream(std::move(source), 4096, dir);
+
+		// Two traversals, leapfrogging each other: each sees every element, and the source is forced once.
+		auto a = spilling.stream(), b = spilling.stream();
+		std::vector<int> seenA, seenB;
+		while(a || b) {
+			for(int i = 0; a && i < 1000; ++i, a = a->tail()) {
+				seenA.push_back(a->head());
+			}
+			for(int i = 0; b && i < 1500; ++i, b = b->tail()) {
+				seenB.push_back(b->head());
+			}
+		}
+		check(seenA == data && seenB == data, "spillingStream: interleaved traversals");
+		check(pulled == data.size(), "spillingStream: ...force the source once per element");
+		check(spilling.resident() == 4096 / sizeof(int) && spilling.resident() + spilling.spilled() == data.size() && filesIn(dir) == 1, "spillingStream: ...keeping only the budget in memory");
+
+		auto copy = spilling;
+		check(toVector(copy.stream()) == data, "spillingStream: a later traversal reads back the spilled elements");
+	}
+	check(filesIn(dir) == 0, "spillingStream: the file is removed once released");
+
+	{
+		auto small = spillingStream(streamOf(std::vector<int>{1, 2, 3}), 4096, dir);
+		check(toVector(small.stream()) == std::vector<int>({1, 2, 3}) && small.spilled() == 0 && filesIn(dir) == 0, "spillingStream: nothing is written when it fits in memory");
+	}
+
+	{
+		std::vector<std::string> words;
+		for(int i = 0; i < 10000; ++i) {
+			words.push_back(std::string(std::size_t(i % 13), char('a' + i % 26)));
+		}
+		auto spilling = spillingStream(streamOf(words), 64 * sizeof(std::string), dir, StringSerializer());
+		check(toVector(spilling.stream()) == words && toVector(spilling.stream()) == words && spilling.spilled() > 0, "spillingStream: with a custom serializer");
+	}
+
+	fs::remove_all(dir);
+	return checkStatus();
+}
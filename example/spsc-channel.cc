@@ -0,0 +1,97 @@
+/************************************************************************************
+ *
+ * Author: Thomas Dickerson
+ * Copyright: 2021, Geopipe, Inc.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ************************************************************************************/
+
+
+#include <functional-cxx/spsc-channel.hpp>
+
+#include <memory>
+#include <numeric>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+#include "example-support.hpp"
+
+using namespace com::geopipe::functional;
+
+/// Push `0, 1, ..., n - 1` from another thread, then close.
+std::thread produce(std::shared_ptr<SpscChannel<int>> channel, int n) {
+	return std::thread([channel, n](){
+		for(int i = 0; i < n; ++i) {
+			channel->push(i);
+		}
+		channel->close();
+	});
+}
+
+int main() {
+	const int n = 100000;
+	std::vector<int> expected(n);
+	std::iota(expected.begin(), expected.end(), 0);
+
+	{
+		// A small ring, so both sides repeatedly block and park.
+		auto channel = std::make_shared<SpscChannel<int>>(8, 16);
+		std::thread producer = produce(channel, n);
+		std::vector<int> seen = toVector(channel->stream());
+		producer.join();
+		check(seen == expected, "stream: every value arrives once, in order, then the Stream ends");
+	}
+
+	{
+		auto channel = std::make_shared<SpscChannel<int>>(1024);
+		std::thread producer = produce(channel, n);
+		std::vector<int> seen;
+		bool bounded = true;
+		for(auto chunks = channel->chunks(64); chunks; chunks = chunks->tail()) {
+			const std::vector<int>& chunk = chunks->head();
+			bounded &= !chunk.empty() && chunk.size() <= 64;
+			seen.insert(seen.end(), chunk.begin(), chunk.end());
+		}
+		producer.join();
+		check(seen == expected && bounded, "chunks: non-empty chunks of at most maxBatch, concatenating to the input");
+	}
+
+	{
+		// Move-only values, popped directly.
+		auto channel = std::make_shared<SpscChannel<std::unique_ptr<int>>>(4);
+		std::thread producer([channel](){
+			for(int i = 0; i < 100; ++i) {
+				channel->push(std::make_unique<int>(i));
+			}
+			channel->close();
+		});
+		int sum = 0, count = 0;
+		while(auto value = channel->pop()) {
+			sum += **value;
+			++count;
+		}
+		producer.join();
+		check(count == 100 && sum == 4950, "pop: move-only values, and an empty optional once closed and drained");
+		bool threw = false;
+		try {
+			channel->push(std::make_unique<int>(0));
+		} catch(const std::logic_error&) {
+			threw = true;
+		}
+		check(threw, "push after close throws std::logic_error");
+	}
+	return checkStatus();
+}
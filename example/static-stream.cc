@@ -0,0 +1,99 @@
+/************************************************************************************
+ *
+ * Author: Thomas Dickerson
+ * Copyright: 2021, Geopipe, Inc.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ************************************************************************************/
+
+
+#include <functional-cxx/static-stream.hpp>
+
+#include <cstddef>
+#include <new>
+#include <numeric>
+#include <vector>
+
+#include "example-support.hpp"
+
+using namespace com::geopipe::functional;
+
+/// Counts heap allocations, to show that a `StaticStream` pipeline makes none.
+std::size_t allocations = 0;
+
+// Forward to the library's aligned forms rather than to `malloc` and `free`, so every allocation is released by its matching function.
+constexpr std::align_val_t kAlignment{alignof(std::max_align_t)};
+
+void* operator new(std::size_t n) {
+	++allocations;
+	return ::operator new(n, kAlignment);
+}
+
+void operator delete(void* p) noexcept {
+	::operator delete(p, kAlignment);
+}
+
+void operator delete(void* p, std::size_t) noexcept {
+	::operator delete(p, kAlignment);
+}
+
+int main() {
+	std::vector<int> data(100000);
+	std::iota(data.begin(), data.end(), 0);
+
+	long expected = 0;
+	for(int x : data) {
+		if(x % 3 == 0) {
+			expected += long(x) * x;
+		}
+	}
+
+	std::size_t before = allocations;
+	long sum = staticRange(data.begin(), data.end())
+		.filter([](int x){ return x % 3 == 0; })
+		.map([](int x){ return long(x) * x; })
+		.fold(0L, [](long a, long b){ return a + b; });
+	check(sum == expected, "StaticStream: filter, map and fold");
+	check(allocations == before, "StaticStream: ...without allocating");
+
+	{
+		// `take` and `takeWhile` never pull the source past what they yield.
+		int pulled = 0;
+		auto counting = [&pulled, i = 0]() mutable -> std::optional<int> {
+			++pulled;
+			return i++;
+		};
+		check(staticStream(counting).take(10).count() == 10 && pulled == 10, "StaticStream::take: stops pulling its source");
+		pulled = 0;
+		std::vector<int> small;
+		for(int x : staticStream(counting).takeWhile([](int x){ return x < 5; })) {
+			small.push_back(x);
+		}
+		check(small == std::vector<int>{0, 1, 2, 3, 4} && pulled == 6, "StaticStream::takeWhile: with range-for");
+	}
+
+	{
+		// `erase` produces an ordinary memoized `Stream`, forced lazily.
+		int pulled = 0;
+		auto s = staticRange(data.begin(), data.end()).map([&pulled](int x){
+			++pulled;
+			return 2 * x;
+		}).erase();
+		auto third = s->tail()->tail();
+		check(third->head() == 4 && pulled == 3, "StaticStream::erase: forces the pipeline as the Stream is forced");
+		check(s->head() == 0 && s->tail()->head() == 2 && pulled == 3, "StaticStream::erase: ...and memoizes it");
+	}
+	return checkStatus();
+}
@@ -0,0 +1,117 @@
+/************************************************************************************
+ *
+ * Author: Thomas Dickerson
+ * Copyright: 2021, Geopipe, Inc.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ************************************************************************************/
+
+
+#include <functional-cxx/time-window.hpp>
+#include <functional-cxx/window.hpp>
+
+#include <chrono>
+#include <map>
+#include <random>
+#include <utility>
+#include <vector>
+
+#include "example-support.hpp"
+
+using namespace com::geopipe::functional;
+
+/// An event: a time, and a value.
+using Event = std::pair<long, int>;
+
+const auto timeOf = [](const Event& e){ return e.first; };
+const auto valueOf = [](const Event& e){ return e.second; };
+
+/// The (sum, count) of the events in each non-empty window `[k * hop, k * hop + size)`, by brute force.
+std::map<long, std::pair<int, std::size_t>> reference(const std::vector<Event>& events, long size, long hop) {
+	std::map<long, std::pair<int, std::size_t>> windows;
+	for(const Event& e : events) {
+		for(long start = e.first / hop * hop; start > e.first - size; start -= hop) {
+			windows[start].first += e.second;
+			++windows[start].second;
+		}
+	}
+	return windows;
+}
+
+template<class S>
+bool matches(S windows, const std::map<long, std::pair<int, std::size_t>>& expected, long size) {
+	auto it = expected.begin();
+	for(; windows; windows = windows->tail(), ++it) {
+		const auto& w = windows->head();
+		if(it == expected.end() || w.start != it->first || w.end != w.start + size || w.aggregate != it->second.first || w.count != it->second.second) {
+			return false;
+		}
+	}
+	return it == expected.end();
+}
+
+int main() {
+	std::mt19937 rng(17);
+	std::vector<Event> events;
+	for(long t = 0; t < 100000; t += long(rng() % 40)) {
+		events.emplace_back(t, int(rng() % 100));
+	}
+
+	check(matches(tumblingWindows(streamOf(events), timeOf, valueOf, sumMonoid<int>(), 100L), reference(events, 100, 100), 100), "tumblingWindows: sums and counts");
+	check(matches(hoppingWindows(streamOf(events), timeOf, valueOf, sumMonoid<int>(), 100L, 25L), reference(events, 100, 25), 100), "hoppingWindows: sums and counts");
+
+	{
+		// Shuffle events up to 50 apart: allowing that much lateness, nothing is lost.
+		std::vector<Event> shuffled(events);
+		for(std::size_t i = 0; i + 1 < shuffled.size(); ++i) {
+			if(rng() % 2 && shuffled[i + 1].first - shuffled[i].first <= 50) {
+				std::swap(shuffled[i], shuffled[i + 1]);
+			}
+		}
+		check(matches(tumblingWindows(streamOf(shuffled), timeOf, valueOf, sumMonoid<int>(), 100L, 50L), reference(events, 100, 100), 100), "tumblingWindows: out-of-order events within the allowed lateness");
+	}
+
+	{
+		std::vector<Event> late{{10, 1}, {120, 1}, {250, 1}, {50, 1}, {260, 1}, {330, 1}};
+		auto w = toVector(tumblingWindows(streamOf(late), timeOf, valueOf, sumMonoid<int>(), 100L));
+		check(w.size() == 4 && w[0].count == 1 && w[2].start == 200 && w[2].count == 2, "tumblingWindows: a late event is dropped");
+		check(w[0].lateDropped + w[1].lateDropped + w[2].lateDropped + w[3].lateDropped == 1, "tumblingWindows: ...and counted");
+	}
+
+	{
+		// Sessions with a gap of 10: an out-of-order event inside an open session is not late,
+		// but one whose own session would already have closed is.
+		std::vector<Event> clicks{{0, 1}, {5, 1}, {10, 1}, {15, 1}, {20, 1}, {25, 1}, {30, 1}, {12, 1}, {100, 1}, {45, 1}};
+		auto s = toVector(sessionWindows(streamOf(clicks), timeOf, valueOf, sumMonoid<int>(), 10L));
+		check(s.size() == 2 && s[0].start == 0 && s[0].end == 40 && s[0].count == 8 && s[0].lateDropped == 0, "sessionWindows: an out-of-order event joins its open session");
+		check(s[1].start == 100 && s[1].count == 1 && s[1].lateDropped == 1, "sessionWindows: an event after its session closed is late");
+
+		std::vector<Event> bridged{{0, 1}, {30, 1}, {15, 1}, {60, 1}};
+		auto b = toVector(sessionWindows(streamOf(bridged), timeOf, valueOf, sumMonoid<int>(), 20L, 100L));
+		check(b.size() == 2 && b[0].start == 0 && b[0].end == 50 && b[0].count == 3 && b[1].start == 60, "sessionWindows: an event may bridge two sessions");
+	}
+
+	{
+		using Clock = std::chrono::steady_clock;
+		Clock::time_point t0{};
+		std::vector<std::pair<Clock::time_point, int>> stamped;
+		for(int i = 0; i < 10; ++i) {
+			stamped.emplace_back(t0 + std::chrono::milliseconds(150 * i), 1);
+		}
+		auto w = toVector(tumblingWindows(streamOf(stamped), [](const auto& e){ return e.first; }, [](const auto& e){ return e.second; }, sumMonoid<int>(), Clock::duration(std::chrono::seconds(1))));
+		check(w.size() == 2 && w[0].count == 7 && w[1].count == 3, "tumblingWindows: with std::chrono time points");
+	}
+	return checkStatus();
+}
@@ -0,0 +1,113 @@
+/************************************************************************************
+ *
+ * Author: Thomas Dickerson
+ * Copyright: 2021, Geopipe, Inc.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ************************************************************************************/
+
+#include <functional-cxx/top-k.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <functional>
+#include <iostream>
+#include <optional>
+#include <random>
+#include <vector>
+
+using namespace com::geopipe::functional;
+
+/// Latency-like samples: mostly small, with a long tail.
+std::vector<std::uint32_t> latencies(std::size_t n, std::uint32_t seed) {
+	std::mt19937 rng(seed);
+	std::lognormal_distribution<double> latency(3.0, 1.0);
+	std::vector<std::uint32_t> result(n);
+	for(auto& x : result) {
+		x = std::uint32_t(latency(rng) * 1000);
+	}
+	return result;
+}
+
+/// A `Stream` of copies of `data`.
+std::shared_ptr<Stream<std::uint32_t>> streamOf(const std::vector<std::uint32_t>& data) {
+	return Stream<std::uint32_t>::Generate([&data, i = std::size_t(0)]() mutable -> std::optional<std::uint32_t> {
+		return i < data.size() ? std::optional<std::uint32_t>(data[i++]) : std::nullopt;
+	});
+}
+
+/// A `Stream` of copies of `data`, in chunks of `chunk` elements.
+std::shared_ptr<Stream<std::vector<std::uint32_t>>> chunksOf(const std::vector<std::uint32_t>& data, std::size_t chunk) {
+	return Stream<std::vector<std::uint32_t>>::Generate([&data, chunk, i = std::size_t(0)]() mutable -> std::optional<std::vector<std::uint32_t>> {
+		if(i >= data.size()) {
+			return std::nullopt;
+		}
+		std::size_t end = std::min(data.size(), i + chunk);
+		std::vector<std::uint32_t> result(data.begin() + i, data.begin() + end);
+		i = end;
+		return result;
+	});
+}
+
+template<class F>
+double millis(F && f) {
+	auto start = std::chrono::steady_clock::now();
+	f();
+	return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+int main(int argc, const char *argv[]) {
+	std::size_t n = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 10000000;
+	std::size_t k = argc > 2 ? std::strtoul(argv[2], nullptr, 10) : 100;
+	std::vector<std::uint32_t> data = latencies(n, 42);
+	std::cout << n << " samples, k = " << k << std::endl;
+
+	std::vector<std::uint32_t> expected;
+	std::cout << "materialize + sort:     " << millis([&](){
+		std::vector<std::uint32_t> all;
+		for(auto s = streamOf(data); s; s = s->tail()) {
+			all.push_back(s->head());
+		}
+		std::sort(all.begin(), all.end(), std::greater<>());
+		all.resize(std::min(k, all.size()));
+		expected = std::move(all);
+	}) << " ms" << std::endl;
+
+	std::vector<std::uint32_t> top;
+	std::cout << "topK:                   " << millis([&](){
+		top = topK(streamOf(data), k);
+	}) << " ms (" << (top == expected ? "agrees" : "DISAGREES") << ")" << std::endl;
+	bool agrees = top == expected;
+
+	std::cout << "topKChunks (4096):      " << millis([&](){
+		top = topKChunks(chunksOf(data, 4096), k);
+	}) << " ms (" << (top == expected ? "agrees" : "DISAGREES") << ")" << std::endl;
+	agrees &= top == expected;
+
+	std::cout << "vector sort (no Stream): " << millis([&](){
+		std::vector<std::uint32_t> all(data);
+		std::sort(all.begin(), all.end(), std::greater<>());
+	}) << " ms" << std::endl;
+
+	std::cout << "TopK::addBatch (vector): " << millis([&](){
+		TopK<std::uint32_t> t(k);
+		t.addBatch(data.begin(), data.end());
+		top = t.sorted();
+	}) << " ms (" << (top == expected ? "agrees" : "DISAGREES") << ")" << std::endl;
+	agrees &= top == expected;
+	return agrees ? 0 : 1;
+}
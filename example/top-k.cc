@@ -0,0 +1,128 @@
+/************************************************************************************
+ *
+ * Author: Thomas Dickerson
+ * Copyright: 2021, Geopipe, Inc.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ************************************************************************************/
+
+
+#include <functional-cxx/top-k.hpp>
+
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <random>
+#include <vector>
+
+#include "example-support.hpp"
+
+using namespace com::geopipe::functional;
+
+/// Whether `hh` satisfies the Misra-Gries guarantees with respect to the true counts `truth`.
+bool bounded(const HeavyHitters<int>& hh, const std::map<int, std::uint64_t>& truth) {
+	std::uint64_t sum = 0;
+	bool ok = true;
+	auto candidates = hh.candidates();
+	for(const auto& [e, count] : candidates) {
+		std::uint64_t actual = truth.at(e);
+		sum += count;
+		ok &= count <= actual && actual - count <= hh.error();
+	}
+	// Every element more frequent than total / (k + 1) is a candidate.
+	for(const auto& [e, actual] : truth) {
+		if(actual > hh.total() / (hh.k() + 1)) {
+			ok &= std::any_of(candidates.begin(), candidates.end(), [e = e](const auto& c){ return c.first == e; });
+		}
+	}
+	// Each reduction removes k + 1 times its amount from the total, and the error is the sum of those amounts.
+	return ok && hh.error() == (hh.total() - sum) / (hh.k() + 1);
+}
+
+int main() {
+	std::mt19937 rng(27);
+	std::vector<int> data(100000);
+	for(int& x : data) {
+		x = int(rng() % 50000);
+	}
+	std::vector<int> sorted(data);
+	std::sort(sorted.begin(), sorted.end(), std::greater<>());
+
+	check(topK(streamOf(data), 100) == std::vector<int>(sorted.begin(), sorted.begin() + 100), "topK: the greatest, in order");
+	check(topK(streamOf(data), 100, std::greater<>()) == std::vector<int>(sorted.rbegin(), sorted.rbegin() + 100), "topK: the least, with std::greater");
+	check(topK(streamOf(std::vector<int>{3, 1, 2}), 10) == std::vector<int>({3, 2, 1}), "topK: all of a short source");
+
+	{
+		std::vector<std::vector<int>> chunks;
+		for(std::size_t i = 0; i < data.size(); i += 999) {
+			chunks.emplace_back(data.begin() + i, data.begin() + std::min(data.size(), i + 999));
+		}
+		check(topKChunks(streamOf(chunks), 100) == std::vector<int>(sorted.begin(), sorted.begin() + 100), "topKChunks: by batches");
+
+		std::vector<TopK<int>> shards(4, TopK<int>(100));
+		for(std::size_t i = 0; i < chunks.size(); ++i) {
+			shards[i % 4].addBatch(chunks[i].begin(), chunks[i].end());
+		}
+		for(std::size_t i = 1; i < shards.size(); ++i) {
+			shards[0].merge(shards[i]);
+		}
+		check(shards[0].sorted() == std::vector<int>(sorted.begin(), sorted.begin() + 100), "TopK::merge: of shards");
+	}
+
+	{
+		std::vector<int> small{5, 1, 9, 3, 7, 9, 2};
+		bool right = true;
+		std::size_t n = 0;
+		for(auto s = runningTopK(streamOf(small), 3); s; s = s->tail(), ++n) {
+			std::vector<int> prefix(small.begin(), small.begin() + n + 1);
+			std::sort(prefix.begin(), prefix.end(), std::greater<>());
+			prefix.resize(std::min<std::size_t>(prefix.size(), 3));
+			right &= s->head() == prefix;
+		}
+		check(right && n == small.size(), "runningTopK: a snapshot per prefix");
+	}
+
+	{
+		// Check the guarantees after every addition, over skewed inputs and various k.
+		bool ok = true;
+		for(int trial = 0; trial < 2000 && ok; ++trial) {
+			HeavyHitters<int> hh(1 + trial % 6);
+			std::map<int, std::uint64_t> truth;
+			std::geometric_distribution<int> skewed(0.15);
+			for(int n = 0; n < 500 && ok; ++n) {
+				int e = skewed(rng) % 40;
+				hh.add(e);
+				++truth[e];
+				ok &= bounded(hh, truth);
+			}
+		}
+		check(ok, "HeavyHitters: counts are lower bounds, short by at most error()");
+
+		HeavyHitters<int> a(8), b(8);
+		std::map<int, std::uint64_t> truth;
+		std::geometric_distribution<int> skewed(0.1);
+		for(int n = 0; n < 20000; ++n) {
+			int e = skewed(rng);
+			(n % 2 ? a : b).add(e);
+			++truth[e];
+		}
+		a.merge(b);
+		check(a.total() == 20000 && bounded(a, truth), "HeavyHitters::merge: preserves the guarantees");
+		auto candidates = a.candidates();
+		check(std::is_sorted(candidates.begin(), candidates.end(), [](const auto& x, const auto& y){ return x.second > y.second; }), "HeavyHitters: candidates, most frequent first");
+	}
+	return checkStatus();
+}
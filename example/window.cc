@@ -0,0 +1,95 @@
+/************************************************************************************
+ *
+ * Author: Thomas Dickerson
+ * Copyright: 2021, Geopipe, Inc.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ************************************************************************************/
+
+
+#include <functional-cxx/window.hpp>
+
+#include <algorithm>
+#include <limits>
+#include <numeric>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "example-support.hpp"
+
+using namespace com::geopipe::functional;
+
+int main() {
+	std::mt19937 rng(9);
+	std::vector<int> data(10000);
+	for(int& x : data) {
+		x = int(rng() % 1000) - 500;
+	}
+	const std::size_t w = 37;
+
+	{
+		bool right = true;
+		std::size_t i = 0;
+		for(auto s = window(streamOf(data), w); s; s = s->tail(), ++i) {
+			const Window<int>& win = s->head();
+			right &= win.size() == w && win.front() == data[i] && std::equal(win.begin(), win.end(), data.begin() + i);
+		}
+		check(right && i == data.size() - w + 1, "window: every window, in order");
+		check(!window(streamOf(std::vector<int>{1, 2}), 3), "window: a shorter source yields no windows");
+		bool threw = false;
+		try {
+			window(streamOf(data), 0);
+		} catch(const std::invalid_argument&) {
+			threw = true;
+		}
+		check(threw, "window: a zero size throws std::invalid_argument");
+	}
+
+	{
+		std::vector<long> sums;
+		std::vector<int> mins, maxes;
+		for(std::size_t i = 0; i + w <= data.size(); ++i) {
+			sums.push_back(std::accumulate(data.begin() + i, data.begin() + i + w, 0L));
+			mins.push_back(*std::min_element(data.begin() + i, data.begin() + i + w));
+			maxes.push_back(*std::max_element(data.begin() + i, data.begin() + i + w));
+		}
+		check(toVector(windowAggregate(streamOf(data), w, sumMonoid<long>())) == sums, "windowAggregate: sums");
+		check(toVector(windowAggregate(streamOf(data), w, minMonoid<int>())) == mins, "windowAggregate: minima");
+
+		std::size_t combines = 0;
+		auto countingMax = monoid(std::numeric_limits<int>::lowest(), [&combines](int a, int b){
+			++combines;
+			return std::max(a, b);
+		});
+		check(toVector(windowAggregate(streamOf(data), w, countingMax)) == maxes, "windowAggregate: maxima");
+		check(combines < 4 * data.size(), "windowAggregate: ...with amortized O(1) combines per window");
+	}
+
+	{
+		// The monoid need not be commutative.
+		auto concat = monoid(std::string(), [](const std::string& a, const std::string& b){
+			return a + b;
+		});
+		std::vector<std::string> letters;
+		for(char c = 'a'; c <= 'z'; ++c) {
+			letters.emplace_back(1, c);
+		}
+		auto windows = toVector(windowAggregate(streamOf(letters), 4, concat));
+		check(windows.size() == 23 && windows.front() == "abcd" && windows.back() == "wxyz", "windowAggregate: in order");
+	}
+	return checkStatus();
+}
@@ -0,0 +1,101 @@
+#pragma once
+/************************************************************************************
+ *
+ * Author: Thomas Dickerson
+ * Copyright: 2021, Geopipe, Inc.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ************************************************************************************/
+
+#include <cstddef>
+#include <stdexcept>
+#include <vector>
+
+namespace com {
+	namespace geopipe {
+		/**************************************************
+		 * Tools for functional programming
+		 **************************************************/
+		namespace functional {
+			/**************************************************
+			 * A static weighted digraph over the vertices `[0, n)`
+			 * in compressed sparse row form.
+			 *
+			 * The out-edges of each vertex are contiguous, and the
+			 * edges of consecutive vertices are adjacent in memory,
+			 * so scanning a neighbourhood is a linear read.
+			 **************************************************/
+			template<class Weight>
+			class AdjacencyArray {
+			public:
+				struct Edge {
+					std::size_t target;
+					Weight weight;
+				};
+
+				/// An input edge for `AdjacencyArray::AdjacencyArray`.
+				struct Arc {
+					std::size_t source;
+					std::size_t target;
+					Weight weight;
+				};
+
+				/// A contiguous range of `Edge`s.
+				class Neighbors {
+					const Edge *begin_;
+					const Edge *end_;
+				public:
+					Neighbors(const Edge *b, const Edge *e) : begin_(b), end_(e) {}
+					const Edge* begin() const { return begin_; }
+					const Edge* end() const { return end_; }
+					std::size_t size() const { return end_ - begin_; }
+				};
+			private:
+				std::vector<std::size_t> offsets_;
+				std::vector<Edge> edges_;
+			public:
+				/// Build from an unordered list of `arcs`, by counting sort on the source vertex.
+				AdjacencyArray(std::size_t vertexCount, const std::vector<Arc> &arcs)
+				: offsets_(vertexCount + 1, 0), edges_(arcs.size()) {
+					for(const Arc& a : arcs) {
+						if(a.source >= vertexCount || a.target >= vertexCount) {
+							throw std::out_of_range("AdjacencyArray arc refers to a vertex which does not exist");
+						}
+						++offsets_[a.source + 1];
+					}
+					for(std::size_t v = 0; v < vertexCount; ++v) {
+						offsets_[v + 1] += offsets_[v];
+					}
+					std::vector<std::size_t> fill(offsets_.begin(), offsets_.end() - 1);
+					for(const Arc& a : arcs) {
+						edges_[fill[a.source]++] = Edge{a.target, a.weight};
+					}
+				}
+
+				std::size_t vertexCount() const {
+					return offsets_.size() - 1;
+				}
+
+				std::size_t edgeCount() const {
+					return edges_.size();
+				}
+
+				Neighbors neighbors(std::size_t v) const {
+					return Neighbors(edges_.data() + offsets_[v], edges_.data() + offsets_[v + 1]);
+				}
+			};
+		}
+	}
+}
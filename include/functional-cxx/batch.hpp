@@ -0,0 +1,291 @@
+#pragma once
+/************************************************************************************
+ *
+ * Author: Thomas Dickerson
+ * Copyright: 2021, Geopipe, Inc.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ************************************************************************************/
+
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+#include <functional-cxx/stream.hpp>
+#include <functional-cxx/support/generators.hpp>
+
+namespace com {
+	namespace geopipe {
+		/**************************************************
+		 * Tools for functional programming
+		 **************************************************/
+		namespace functional {
+			/**************************************************
+			 * Internal implementation details
+			 **************************************************/
+			namespace detail {
+				/**************************************************
+				 * A free list of emptied `std::vector`s, so that batches
+				 * recycle their storage. A `Batch` may be destroyed on
+				 * any thread, so the list is behind a mutex, which is
+				 * only ever briefly held.
+				 **************************************************/
+				template<class E>
+				class BatchPool {
+					std::mutex mutex_;
+					std::vector<std::vector<E>> free_;
+					std::size_t maxFree_;
+				public:
+					explicit BatchPool(std::size_t maxFree)
+					: maxFree_(maxFree) {}
+
+					/// An empty vector, with capacity for at least `capacity` elements if we had one spare.
+					std::vector<E> acquire(std::size_t capacity) {
+						std::vector<E> result;
+						{
+							std::lock_guard<std::mutex> lock(mutex_);
+							if(!free_.empty()) {
+								result = std::move(free_.back());
+								free_.pop_back();
+							}
+						}
+						result.reserve(capacity);
+						return result;
+					}
+
+					void release(std::vector<E> && buffer) {
+						buffer.clear();
+						std::lock_guard<std::mutex> lock(mutex_);
+						if(free_.size() < maxFree_) {
+							free_.push_back(std::move(buffer));
+						}
+					}
+				};
+			}
+
+			/**************************************************
+			 * A batch of consecutive elements of a `Stream`, as
+			 * produced by `batch`, `batchBy` and `groupAdjacentBy`.
+			 *
+			 * It is a read-only, contiguous range (like a span), whose
+			 * storage is returned to its combinator's pool when the
+			 * `Batch` is destroyed; that is, when the consumer releases
+			 * the `Stream` cell holding it. So a consumer which walks
+			 * the result without retaining cells makes no allocations
+			 * in the steady state. Call `take` to keep the storage.
+			 **************************************************/
+			template<class E>
+			class Batch {
+				std::vector<E> items_;
+				std::shared_ptr<detail::BatchPool<E>> pool_;
+			public:
+				using value_type = E;
+				using const_iterator = typename std::vector<E>::const_iterator;
+
+				Batch(std::vector<E> && items, std::shared_ptr<detail::BatchPool<E>> pool)
+				: items_(std::move(items)), pool_(std::move(pool)) {}
+
+				Batch(const Batch&) = default;
+				Batch(Batch &&) = default;
+
+				Batch& operator=(Batch other) {
+					std::swap(items_, other.items_);
+					std::swap(pool_, other.pool_);
+					return *this;
+				}
+
+				~Batch() {
+					if(pool_ && items_.capacity()) {
+						pool_->release(std::move(items_));
+					}
+				}
+
+				std::size_t size() const {
+					return items_.size();
+				}
+
+				bool empty() const {
+					return items_.empty();
+				}
+
+				const E* data() const {
+					return items_.data();
+				}
+
+				const E& operator[](std::size_t i) const {
+					return items_[i];
+				}
+
+				const E& front() const {
+					return items_.front();
+				}
+
+				const E& back() const {
+					return items_.back();
+				}
+
+				const_iterator begin() const {
+					return items_.begin();
+				}
+
+				const_iterator end() const {
+					return items_.end();
+				}
+
+				/// Detach the elements from the pool, and move them out.
+				std::vector<E> take() && {
+					pool_ = nullptr;
+					return std::move(items_);
+				}
+			};
+
+			/// Tuning knobs for the batching combinators.
+			struct BatchOptions {
+				std::size_t reserve = 0; ///< Capacity to reserve in each new buffer.
+				std::size_t pooled = 8; ///< Released buffers kept for reuse. At least two are needed for steady-state reuse by a consumer walking the result.
+			};
+
+			namespace detail {
+				/// `BatchGen` policy closing each batch as soon as it holds `n` elements, so nothing is pulled ahead.
+				struct FixedSize {
+					std::size_t n;
+
+					template<class Items>
+					bool full(const Items& items) const {
+						return items.size() >= n;
+					}
+
+					template<class Items, class E>
+					bool fits(const Items&, const E&) const {
+						return true;
+					}
+				};
+
+				/// `BatchGen` policy deferring to `Fits(batch, next)`, which must see the element after each batch.
+				template<class Fits>
+				struct Lookahead {
+					Fits f;
+
+					template<class Items>
+					bool full(const Items&) const {
+						return false;
+					}
+
+					template<class Items, class E>
+					bool fits(const Items& items, const E& next) {
+						return f(items, next);
+					}
+				};
+
+				/**************************************************
+				 * Yields `Batch`es of consecutive elements of `Src`.
+				 * A batch is closed without pulling another element once
+				 * `Boundary::full(batch)`; otherwise the next element is
+				 * pulled, and `Boundary::fits(batch, next)` decides whether
+				 * it joins the non-empty `batch` so far. If not, it begins
+				 * the next batch, so one element is held in lookahead.
+				 **************************************************/
+				template<class Src, class Boundary>
+				class BatchGen {
+					using E = GeneratedT<Src>;
+					Src src_;
+					Boundary fits_;
+					std::optional<E> pending_;
+					std::shared_ptr<BatchPool<E>> pool_;
+					std::size_t reserve_;
+				public:
+					BatchGen(Src && src, Boundary && fits, const BatchOptions& options)
+					: src_(std::move(src)), fits_(std::move(fits)), pool_(std::make_shared<BatchPool<E>>(options.pooled)), reserve_(options.reserve) {}
+
+					std::optional<Batch<E>> operator()() {
+						if(!pending_) {
+							pending_ = src_();
+							if(!pending_) {
+								return std::nullopt;
+							}
+						}
+						std::vector<E> items = pool_->acquire(reserve_);
+						items.push_back(std::move(*pending_));
+						pending_.reset();
+						while(!fits_.full(std::as_const(items))) {
+							pending_ = src_();
+							if(!pending_ || !fits_.fits(std::as_const(items), std::as_const(*pending_))) {
+								break;
+							}
+							items.push_back(std::move(*pending_));
+							pending_.reset();
+						}
+						return Batch<E>(std::move(items), pool_);
+					}
+				};
+
+				template<class E, class Boundary>
+				std::shared_ptr<Stream<Batch<E>>> batchWith(std::shared_ptr<Stream<E>> && source, Boundary && fits, const BatchOptions& options) {
+					using G = BatchGen<StreamGen<std::shared_ptr<Stream<E>>>, std::decay_t<Boundary>>;
+					return Stream<Batch<E>>::Generate(G(StreamGen<std::shared_ptr<Stream<E>>>(std::move(source)), std::forward<Boundary>(fits), options));
+				}
+			}
+
+			/**************************************************
+			 * A lazy `Stream` of `Batch`es of `n` consecutive elements
+			 * of `source` (the last may be shorter). Each is filled
+			 * when its cell is forced, forcing no element of `source`
+			 * beyond its own, and its storage is recycled once
+			 * released: see `Batch`.
+			 **************************************************/
+			template<class E>
+			std::shared_ptr<Stream<Batch<E>>> batch(std::shared_ptr<Stream<E>> source, std::size_t n, BatchOptions options = BatchOptions()) {
+				if(!n) {
+					throw std::invalid_argument("batch: the batch size must be positive");
+				}
+				if(!options.reserve) {
+					options.reserve = n;
+				}
+				return detail::batchWith(std::move(source), detail::FixedSize{n}, options);
+			}
+
+			/**************************************************
+			 * A lazy `Stream` of `Batch`es of consecutive elements of
+			 * `source`, where `fits(items, next)` decides whether `next`
+			 * may join the (non-empty) batch `items`, e.g. to bound
+			 * each batch's size in bytes. An element which does not
+			 * fit begins the next batch, so no batch is empty.
+			 **************************************************/
+			template<class E, class Fits>
+			std::shared_ptr<Stream<Batch<E>>> batchBy(std::shared_ptr<Stream<E>> source, Fits fits, const BatchOptions& options = BatchOptions()) {
+				return detail::batchWith(std::move(source), detail::Lookahead<Fits>{std::move(fits)}, options);
+			}
+
+			/**************************************************
+			 * A lazy `Stream` of the maximal runs of consecutive
+			 * elements of `source` with equal `key(e)`, as `Batch`es.
+			 * Unlike a full group-by, equal keys which are not
+			 * adjacent form separate runs, so this needs no memory
+			 * beyond the current run.
+			 **************************************************/
+			template<class E, class Key>
+			std::shared_ptr<Stream<Batch<E>>> groupAdjacentBy(std::shared_ptr<Stream<E>> source, Key key, const BatchOptions& options = BatchOptions()) {
+				auto sameKey = [key = std::move(key)](const std::vector<E>& items, const E& next){
+					return key(items.front()) == key(next);
+				};
+				return detail::batchWith(std::move(source), detail::Lookahead<decltype(sameKey)>{std::move(sameKey)}, options);
+			}
+		}
+	}
+}
@@ -0,0 +1,219 @@
+#pragma once
+/************************************************************************************
+ *
+ * Author: Thomas Dickerson
+ * Copyright: 2021, Geopipe, Inc.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ************************************************************************************/
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <optional>
+#include <utility>
+#include <vector>
+
+#include <functional-cxx/stream.hpp>
+#include <functional-cxx/support/hashing.hpp>
+#include <functional-cxx/support/open-hash-table.hpp>
+
+namespace com {
+	namespace geopipe {
+		/**************************************************
+		 * Tools for functional programming
+		 **************************************************/
+		namespace functional {
+			/// A state in the order it was expanded by a `bestFirstStream`.
+			template<class State, class Cost>
+			struct Expanded {
+				State state;
+				Cost cost; ///< Cost of the best known path from the start, `g`.
+				Cost estimate; ///< `g + h`, the priority it was expanded at.
+			};
+
+			/// Tuning knobs for `bestFirstStream`.
+			struct SearchOptions {
+				/**************************************************
+				 * If non-zero, the open list is pruned back to the
+				 * `beamWidth` most promising entries whenever it grows
+				 * to twice that size (so pruning is amortized O(1) per push).
+				 * This makes the search incomplete, and bounds the open
+				 * list, but not the search's memory: every state ever
+				 * generated is still kept, with its best known cost, to
+				 * detect duplicates. So a pruned state is only reopened
+				 * if it is later reached by a strictly cheaper path.
+				 **************************************************/
+				std::size_t beamWidth = 0;
+			};
+
+			/**************************************************
+			 * Internal implementation details
+			 **************************************************/
+			namespace detail {
+				/**************************************************
+				 * Generator for `bestFirstStream`.
+				 *
+				 * Every distinct state is stored exactly once, in `nodes_`.
+				 * The closed set / best-cost index is an `OpenHashMap`
+				 * keyed on 32-bit `NodeIndex`es into `nodes_`, hashed
+				 * through the arena, and the open list is a binary heap of
+				 * `(estimate, index)` pairs with lazy deletion of entries
+				 * made stale by a later improvement.
+				 **************************************************/
+				template<class State, class Cost, class Successors, class Heuristic, class StateHash>
+				class BestFirstF {
+					struct Node {
+						State state;
+						Cost cost;
+						bool closed;
+					};
+
+					struct OpenEntry {
+						Cost estimate;
+						Cost cost;
+						std::uint32_t node;
+					};
+
+					/// Orders a max-heap so that the least estimate (then greatest cost, i.e. deepest) is on top.
+					struct Worse {
+						bool operator()(const OpenEntry& a, const OpenEntry& b) const {
+							return b.estimate < a.estimate || (!(a.estimate < b.estimate) && a.cost < b.cost);
+						}
+					};
+
+					/// An index into `nodes_`, distinct from `State` even when that is itself an integer.
+					struct NodeIndex {
+						std::uint32_t i;
+					};
+
+					struct ArenaHash {
+						const std::vector<Node> *nodes;
+						StateHash hash;
+						std::uint64_t operator()(NodeIndex n) const { return hash((*nodes)[n.i].state); }
+						std::uint64_t operator()(const State& s) const { return hash(s); }
+					};
+
+					struct ArenaEq {
+						const std::vector<Node> *nodes;
+						bool operator()(NodeIndex m, NodeIndex n) const { return m.i == n.i; }
+						bool operator()(NodeIndex n, const State& s) const { return (*nodes)[n.i].state == s; }
+					};
+
+					// Held by pointer, because the index refers back into the arena.
+					std::unique_ptr<std::vector<Node>> nodes_;
+					OpenHashMap<NodeIndex, Unit, ArenaHash, ArenaEq> index_;
+					std::vector<OpenEntry> open_;
+					Successors successors_;
+					Heuristic heuristic_;
+					SearchOptions options_;
+					std::optional<std::uint32_t> unexpanded_;
+
+					void push(OpenEntry && e) {
+						open_.push_back(std::move(e));
+						std::push_heap(open_.begin(), open_.end(), Worse());
+						if(options_.beamWidth && open_.size() >= 2 * options_.beamWidth) {
+							std::nth_element(open_.begin(), open_.begin() + options_.beamWidth, open_.end(), [](const OpenEntry& a, const OpenEntry& b){
+								return Worse()(b, a);
+							});
+							open_.resize(options_.beamWidth);
+							std::make_heap(open_.begin(), open_.end(), Worse());
+						}
+					}
+
+					void relax(State && next, const Cost& cost) {
+						std::vector<Node> &nodes = *nodes_;
+						std::uint32_t i;
+						if(const NodeIndex* known = index_.findKey(next)) {
+							i = known->i;
+							Node& n = nodes[i];
+							if(n.closed || !(cost < n.cost)) {
+								return;
+							}
+							n.cost = cost;
+						} else {
+							i = std::uint32_t(nodes.size());
+							nodes.push_back(Node{std::move(next), cost, false});
+							index_.tryEmplace(NodeIndex{i});
+						}
+						push(OpenEntry{cost + heuristic_(nodes[i].state), cost, i});
+					}
+				public:
+					BestFirstF(State && start, Successors && successors, Heuristic && heuristic, const SearchOptions& options)
+					: nodes_(std::make_unique<std::vector<Node>>()), index_(16, ArenaHash{nodes_.get(), StateHash()}, ArenaEq{nodes_.get()}),
+					  successors_(std::move(successors)), heuristic_(std::move(heuristic)), options_(options) {
+						relax(std::move(start), Cost());
+					}
+
+					std::optional<Expanded<State, Cost>> operator()() {
+						std::vector<Node> &nodes = *nodes_;
+						if(unexpanded_) {
+							std::uint32_t from = *unexpanded_;
+							unexpanded_.reset();
+							Cost base = nodes[from].cost;
+							// `relax` may grow `nodes`, so we must not hold a reference into it across the call.
+							State current = nodes[from].state;
+							successors_(current, [&](State next, const Cost& step){
+								relax(std::move(next), base + step);
+							});
+						}
+						while(!open_.empty()) {
+							std::pop_heap(open_.begin(), open_.end(), Worse());
+							OpenEntry e = std::move(open_.back());
+							open_.pop_back();
+							Node& n = nodes[e.node];
+							if(n.closed || n.cost < e.cost) {
+								continue; // stale
+							}
+							n.closed = true;
+							unexpanded_ = e.node;
+							return Expanded<State, Cost>{n.state, n.cost, e.estimate};
+						}
+						return std::nullopt;
+					}
+				};
+			}
+
+			/**************************************************
+			 * Best-first (A*) search as a `Stream` of `Expanded`
+			 * states, in the order they are expanded.
+			 *
+			 * @arg successors is invoked as `successors(state, yield)`,
+			 * and should call `yield(next, stepCost)` for each neighbour,
+			 * so no intermediate containers are allocated.
+			 * @arg heuristic estimates the remaining cost from a state.
+			 * With a consistent heuristic, each state is expanded at most
+			 * once and at its optimal cost; with `heuristic` returning zero
+			 * this is uniform-cost search.
+			 *
+			 * A state's successors are only generated when the next element
+			 * is forced, so combining this with `Stream::find` or
+			 * `Stream::takeWhile` stops the search exactly where the
+			 * consumer stops.
+			 *
+			 * `State` must be equality comparable and hashable by `StateHash`.
+			 **************************************************/
+			template<class State, class Cost, class Successors, class Heuristic, class StateHash = detail::Hash<State>>
+			std::shared_ptr<Stream<Expanded<State, Cost>>> bestFirstStream(State start, Successors successors, Heuristic heuristic, SearchOptions options = SearchOptions()) {
+				auto search = std::make_unique<detail::BestFirstF<State, Cost, Successors, Heuristic, StateHash>>(std::move(start), std::move(successors), std::move(heuristic), options);
+				return Stream<Expanded<State, Cost>>::Generate([search = std::move(search)](){
+					return (*search)();
+				});
+			}
+		}
+	}
+}
@@ -0,0 +1,339 @@
+#pragma once
+/************************************************************************************
+ *
+ * Author: Thomas Dickerson
+ * Copyright: 2021, Geopipe, Inc.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ************************************************************************************/
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <optional>
+#include <utility>
+#include <vector>
+
+#include <functional-cxx/stream.hpp>
+#include <functional-cxx/support/memory-hacks.hpp>
+#include <functional-cxx/support/parking.hpp>
+
+namespace com {
+	namespace geopipe {
+		/**************************************************
+		 * Tools for functional programming
+		 **************************************************/
+		namespace functional {
+			/**************************************************
+			 * A bounded multi-producer channel whose consumer side
+			 * can be viewed as a `Stream`, for fanning many ingest
+			 * threads into one logical stream.
+			 *
+			 * The queue itself is Vyukov's bounded MPMC array queue:
+			 * each slot carries a sequence number, so producers and
+			 * consumers only contend on a single CAS of their own index.
+			 * Producers block (spin, then park) while the channel is
+			 * full, which propagates backpressure upstream.
+			 *
+			 * Shutdown is clean: after `Channel::close`, further pushes
+			 * are rejected, but everything accepted before that is still
+			 * delivered before the consumer observes end-of-stream.
+			 * Alternatively, hand each producer thread a `Channel::Producer`
+			 * and the channel closes itself when the last one is released.
+			 *
+			 * Must be owned by a `std::shared_ptr`, since the
+			 * `Stream` views keep the channel alive.
+			 **************************************************/
+			template<class E>
+			class Channel : public std::enable_shared_from_this<Channel<E>> {
+				using StreamT = std::shared_ptr<Stream<E>>;
+				using ChunkStreamT = std::shared_ptr<Stream<std::vector<E>>>;
+
+				struct Slot {
+					std::atomic<std::size_t> sequence;
+					detail::AlignedFor<E> storage;
+
+					E* value() {
+						return std::launder(reinterpret_cast<E*>(&storage));
+					}
+				};
+
+				const std::size_t mask_;
+				const std::size_t spins_;
+				std::unique_ptr<Slot[]> slots_;
+
+				alignas(detail::kCacheLineSize) std::atomic<std::size_t> tail_;
+				alignas(detail::kCacheLineSize) std::atomic<std::size_t> head_;
+				alignas(detail::kCacheLineSize) std::atomic<std::size_t> writers_; ///< Pushes in flight.
+				std::atomic<std::size_t> producers_; ///< Outstanding `Channel::Producer` handles.
+				std::atomic<bool> closed_;
+
+				detail::Parker notEmpty_;
+				detail::Parker notFull_;
+
+				static std::size_t roundUpPow2(std::size_t n) {
+					std::size_t result = 2;
+					while(result < n) {
+						result <<= 1;
+					}
+					return result;
+				}
+
+				template<class A>
+				bool tryEnqueue(A && e) {
+					std::size_t pos = tail_.load(std::memory_order_relaxed);
+					for(;;) {
+						Slot& slot = slots_[pos & mask_];
+						std::size_t sequence = slot.sequence.load(std::memory_order_acquire);
+						std::ptrdiff_t dif = std::ptrdiff_t(sequence) - std::ptrdiff_t(pos);
+						if(dif == 0) {
+							if(tail_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+								new (slot.value()) E(std::forward<A>(e));
+								slot.sequence.store(pos + 1, std::memory_order_release);
+								return true;
+							}
+						} else if(dif < 0) {
+							return false;
+						} else {
+							pos = tail_.load(std::memory_order_relaxed);
+						}
+					}
+				}
+
+				bool tryDequeue(std::vector<E> &out) {
+					std::size_t pos = head_.load(std::memory_order_relaxed);
+					for(;;) {
+						Slot& slot = slots_[pos & mask_];
+						std::size_t sequence = slot.sequence.load(std::memory_order_acquire);
+						std::ptrdiff_t dif = std::ptrdiff_t(sequence) - std::ptrdiff_t(pos + 1);
+						if(dif == 0) {
+							if(head_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+								E* e = slot.value();
+								out.push_back(std::move(*e));
+								e->~E();
+								slot.sequence.store(pos + mask_ + 1, std::memory_order_release);
+								return true;
+							}
+						} else if(dif < 0) {
+							return false;
+						} else {
+							pos = head_.load(std::memory_order_relaxed);
+						}
+					}
+				}
+
+				bool readable() const {
+					std::size_t pos = head_.load(std::memory_order_relaxed);
+					return std::ptrdiff_t(slots_[pos & mask_].sequence.load(std::memory_order_acquire)) - std::ptrdiff_t(pos + 1) >= 0;
+				}
+
+				bool writable() const {
+					std::size_t pos = tail_.load(std::memory_order_relaxed);
+					return std::ptrdiff_t(slots_[pos & mask_].sequence.load(std::memory_order_acquire)) - std::ptrdiff_t(pos) >= 0;
+				}
+
+				bool drained() const {
+					return closed_.load() && writers_.load() == 0;
+				}
+
+			public:
+				/**************************************************
+				 * A producer's claim on the channel.
+				 * The channel closes itself when the last outstanding
+				 * `Producer` is destroyed, so create all of them before
+				 * starting the producer threads.
+				 **************************************************/
+				class Producer {
+					friend class Channel<E>;
+					std::shared_ptr<Channel<E>> channel_;
+
+					explicit Producer(std::shared_ptr<Channel<E>> channel)
+					: channel_(std::move(channel)) {
+						channel_->producers_.fetch_add(1);
+					}
+
+					/// Give up this claim, closing the channel if it was the last.
+					void release() {
+						if(channel_ && channel_->producers_.fetch_sub(1) == 1) {
+							channel_->close();
+						}
+						channel_ = nullptr;
+					}
+				public:
+					Producer(const Producer&) = delete;
+					Producer& operator=(const Producer&) = delete;
+					Producer(Producer&&) = default;
+
+					/// Releases this handle's previous claim (see `~Producer`) before taking over `other`'s.
+					Producer& operator=(Producer&& other) {
+						if(this != &other) {
+							release();
+							channel_ = std::move(other.channel_);
+						}
+						return *this;
+					}
+
+					~Producer() {
+						release();
+					}
+
+					/// See `Channel::push`.
+					template<class A>
+					bool push(A && e) {
+						return channel_->push(std::forward<A>(e));
+					}
+				};
+
+				/**************************************************
+				 * @arg capacity is rounded up to a power of two.
+				 * @arg spins is the number of polls before a blocked
+				 * producer or consumer parks on a condition variable.
+				 **************************************************/
+				explicit Channel(std::size_t capacity = 1024, std::size_t spins = 1024)
+				: mask_(roundUpPow2(capacity) - 1), spins_(spins), slots_(new Slot[mask_ + 1]),
+				  tail_(0), head_(0), writers_(0), producers_(0), closed_(false) {
+					for(std::size_t i = 0; i <= mask_; ++i) {
+						slots_[i].sequence.store(i, std::memory_order_relaxed);
+					}
+				}
+
+				Channel(const Channel&) = delete;
+				Channel& operator=(const Channel&) = delete;
+
+				~Channel() {
+					std::vector<E> discard;
+					while(tryDequeue(discard)) {
+						discard.clear();
+					}
+				}
+
+				/// Register a producer. See `Channel::Producer`.
+				Producer producer() {
+					return Producer(this->shared_from_this());
+				}
+
+				/**************************************************
+				 * Enqueue `e`, blocking while the channel is full.
+				 * Returns `false` (and drops `e`) if the channel was
+				 * closed before `e` could be accepted.
+				 * Safe to call from any number of threads.
+				 **************************************************/
+				template<class A>
+				bool push(A && e) {
+					writers_.fetch_add(1);
+					bool accepted = false;
+					while(!closed_.load()) {
+						if(tryEnqueue(std::forward<A>(e))) {
+							accepted = true;
+							break;
+						}
+						notFull_.wait([this](){ return writable() || closed_.load(); }, spins_);
+					}
+					writers_.fetch_sub(1);
+					notEmpty_.notify();
+					return accepted;
+				}
+
+				/// Reject further pushes. Values already accepted will still be delivered.
+				void close() {
+					closed_.store(true);
+					notEmpty_.notify();
+					notFull_.notify();
+				}
+
+				/**************************************************
+				 * Wait for at least one value, then dequeue as many as
+				 * are ready, up to `maxBatch`, into `out`.
+				 * Returns `false` once the channel has been closed and drained.
+				 **************************************************/
+				bool popBatch(std::vector<E> &out, std::size_t maxBatch) {
+					std::size_t start = out.size();
+					for(;;) {
+						while(out.size() - start < maxBatch && tryDequeue(out)) {}
+						if(out.size() != start) {
+							notFull_.notify();
+							return true;
+						}
+						if(drained()) {
+							// Every accepted push completed before `writers_` reached zero.
+							if(!tryDequeue(out)) {
+								return false;
+							}
+						} else {
+							notEmpty_.wait([this](){ return readable() || drained(); }, spins_);
+						}
+					}
+				}
+
+				/**************************************************
+				 * Dequeue a single value, waiting if necessary.
+				 * Returns an empty optional once the channel has been
+				 * closed and drained.
+				 **************************************************/
+				std::optional<E> pop() {
+					std::vector<E> one;
+					one.reserve(1);
+					if(popBatch(one, 1)) {
+						return std::move(one.front());
+					}
+					return std::nullopt;
+				}
+
+				/**************************************************
+				 * View the channel as a `Stream`.
+				 * Values are dequeued in batches of up to `maxBatch`
+				 * into a buffer owned by the `Stream`'s thunk, so the
+				 * queue is only touched once per batch.
+				 * Obtaining the `Stream` blocks until the first element
+				 * is available (or the channel is drained).
+				 **************************************************/
+				StreamT stream(std::size_t maxBatch = 256) {
+					struct Buffered {
+						std::shared_ptr<Channel<E>> channel;
+						std::vector<E> buffer;
+						std::size_t next;
+						std::size_t maxBatch;
+
+						std::optional<E> operator()() {
+							if(next == buffer.size()) {
+								buffer.clear();
+								next = 0;
+								if(!channel->popBatch(buffer, maxBatch)) {
+									return std::nullopt;
+								}
+							}
+							return std::move(buffer[next++]);
+						}
+					};
+					return Stream<E>::Generate(Buffered{this->shared_from_this(), {}, 0, maxBatch});
+				}
+
+				/**************************************************
+				 * View the channel as a `Stream` of chunks of up to
+				 * `maxBatch` elements, so that one `Stream::tail` force
+				 * drains everything that is ready.
+				 **************************************************/
+				ChunkStreamT chunks(std::size_t maxBatch = 256) {
+					return Stream<std::vector<E>>::Generate([self = this->shared_from_this(), maxBatch](){
+						std::vector<E> chunk;
+						chunk.reserve(maxBatch);
+						return self->popBatch(chunk, maxBatch) ? std::optional<std::vector<E>>(std::move(chunk)) : std::nullopt;
+					});
+				}
+			};
+		}
+	}
+}
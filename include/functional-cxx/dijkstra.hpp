@@ -0,0 +1,133 @@
+#pragma once
+/************************************************************************************
+ *
+ * Author: Thomas Dickerson
+ * Copyright: 2021, Geopipe, Inc.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ************************************************************************************/
+
+#include <cstddef>
+#include <limits>
+#include <memory>
+#include <optional>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+
+#include <functional-cxx/stream.hpp>
+#include <functional-cxx/support/indexed-heap.hpp>
+
+namespace com {
+	namespace geopipe {
+		/**************************************************
+		 * Tools for functional programming
+		 **************************************************/
+		namespace functional {
+			/// Sentinel used as the `Settled::predecessor` of the source vertex.
+			constexpr std::size_t kNoVertex = std::numeric_limits<std::size_t>::max();
+
+			/// A vertex whose shortest-path distance from the source is final.
+			template<class Weight>
+			struct Settled {
+				std::size_t vertex;
+				Weight distance;
+				std::size_t predecessor; ///< The previous vertex on a shortest path, or `kNoVertex` for the source.
+			};
+
+			/**************************************************
+			 * Internal implementation details
+			 **************************************************/
+			namespace detail {
+				template<class Graph>
+				using EdgeWeightT = std::decay_t<decltype(std::declval<const Graph&>().neighbors(0).begin()->weight)>;
+
+				/**************************************************
+				 * Generator for `dijkstraStream`.
+				 *
+				 * The out-edges of a settled vertex are only relaxed
+				 * when the _next_ vertex is requested, so a consumer
+				 * which stops after `k` vertices never pays to scan
+				 * the neighbourhood of the `k`th.
+				 **************************************************/
+				template<class Graph>
+				class DijkstraF {
+					using Weight = EdgeWeightT<Graph>;
+
+					const Graph &graph_;
+					IndexedDaryHeap<Weight> frontier_;
+					std::unique_ptr<std::size_t[]> predecessor_; ///< Default-initialized: only entries for reached vertices are ever written.
+					std::optional<std::pair<std::size_t, Weight>> unexpanded_;
+
+					void expand(std::size_t v, const Weight& distance) {
+						for(const auto& edge : graph_.neighbors(v)) {
+							if(!frontier_.popped(edge.target) && frontier_.pushOrDecrease(edge.target, distance + edge.weight)) {
+								predecessor_[edge.target] = v;
+							}
+						}
+					}
+				public:
+					DijkstraF(const Graph &graph, std::size_t source)
+					: graph_(graph), frontier_(graph.vertexCount()), predecessor_(new std::size_t[graph.vertexCount() ? graph.vertexCount() : 1]) {
+						if(source >= graph.vertexCount()) {
+							throw std::out_of_range("dijkstraStream source vertex does not exist");
+						}
+						frontier_.pushOrDecrease(source, Weight());
+						predecessor_[source] = kNoVertex;
+					}
+
+					std::optional<Settled<Weight>> operator()() {
+						if(unexpanded_) {
+							expand(unexpanded_->first, unexpanded_->second);
+							unexpanded_.reset();
+						}
+						if(frontier_.empty()) {
+							return std::nullopt;
+						}
+						auto [v, distance] = frontier_.pop();
+						unexpanded_.emplace(v, distance);
+						return Settled<Weight>{v, distance, predecessor_[v]};
+					}
+				};
+			}
+
+			/**************************************************
+			 * Dijkstra's algorithm as a corecursive process: a `Stream`
+			 * of `Settled` vertices in non-decreasing order of distance
+			 * from `source`.
+			 *
+			 * `Graph` must provide `vertexCount()`, and `neighbors(v)`
+			 * returning a range of edges with `target` and `weight` members,
+			 * e.g. `AdjacencyArray`. Edge weights must be non-negative.
+			 *
+			 * The frontier is a 4-ary indexed heap with decrease-key,
+			 * and per-vertex bookkeeping is allocated without being
+			 * initialized, so a consumer which stops early (e.g. once
+			 * its target is settled) pays only for the explored region.
+			 *
+			 * @warning `graph` is held by reference, and must outlive
+			 * the returned `Stream`.
+			 **************************************************/
+			template<class Graph>
+			std::shared_ptr<Stream<Settled<detail::EdgeWeightT<Graph>>>> dijkstraStream(const Graph &graph, std::size_t source) {
+				using Weight = detail::EdgeWeightT<Graph>;
+				auto search = std::make_unique<detail::DijkstraF<Graph>>(graph, source);
+				return Stream<Settled<Weight>>::Generate([search = std::move(search)](){
+					return (*search)();
+				});
+			}
+		}
+	}
+}
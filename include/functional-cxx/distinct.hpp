@@ -0,0 +1,183 @@
+#pragma once
+/************************************************************************************
+ *
+ * Author: Thomas Dickerson
+ * Copyright: 2021, Geopipe, Inc.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ************************************************************************************/
+
+#include <algorithm>
+#include <cstddef>
+#include <memory>
+#include <optional>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+
+#include <functional-cxx/sketch.hpp>
+#include <functional-cxx/stream.hpp>
+#include <functional-cxx/support/generators.hpp>
+#include <functional-cxx/support/hashing.hpp>
+#include <functional-cxx/support/open-hash-table.hpp>
+
+namespace com {
+	namespace geopipe {
+		/**************************************************
+		 * Tools for functional programming
+		 **************************************************/
+		namespace functional {
+			/**************************************************
+			 * Internal implementation details
+			 **************************************************/
+			namespace detail {
+				/// The key function for `distinct`.
+				struct Identity {
+					template<class E>
+					const E& operator()(const E& e) const {
+						return e;
+					}
+				};
+
+				template<class E, class KeyOf>
+				using DistinctKeyT = std::decay_t<std::invoke_result_t<KeyOf&, const E&>>;
+
+				/**************************************************
+				 * Yields the elements of `Src` whose keys `Seen::insert`
+				 * reports as new. Rejected elements are skipped in a loop,
+				 * so, wrapped in `Stream::Generate`, they cost no cells.
+				 **************************************************/
+				template<class Src, class KeyOf, class Seen>
+				class DistinctGen {
+					Src src_;
+					KeyOf keyOf_;
+					Seen seen_;
+				public:
+					DistinctGen(Src && src, KeyOf && keyOf, Seen && seen)
+					: src_(std::move(src)), keyOf_(std::move(keyOf)), seen_(std::move(seen)) {}
+
+					std::optional<GeneratedT<Src>> operator()() {
+						while(auto e = src_()) {
+							if(seen_.insert(keyOf_(std::as_const(*e)))) {
+								return e;
+							}
+						}
+						return std::nullopt;
+					}
+				};
+
+				/**************************************************
+				 * A set remembering (at least) the most recent
+				 * `capacity / 2` distinct keys inserted, and at most
+				 * `capacity`, in two generations: once the current
+				 * generation is full it becomes the previous one,
+				 * and the old previous one is forgotten. Keys found in
+				 * the previous generation are promoted. The tables are
+				 * cleared and reused, so this allocates nothing once warm.
+				 **************************************************/
+				template<class K, class H = Hash<K>>
+				class GenerationalSet {
+					std::size_t generation_;
+					OpenHashSet<K, H> current_;
+					OpenHashSet<K, H> previous_;
+				public:
+					explicit GenerationalSet(std::size_t capacity)
+					: generation_(std::max<std::size_t>(1, capacity / 2)), current_(generation_), previous_(generation_) {}
+
+					/// Insert `key`, and return whether it was not remembered.
+					bool insert(const K& key) {
+						if(current_.contains(key)) {
+							return false;
+						}
+						bool remembered = previous_.contains(key);
+						if(current_.size() >= generation_) {
+							std::swap(current_, previous_);
+							current_.clear();
+						}
+						current_.insert(key);
+						return !remembered;
+					}
+				};
+
+				template<class E, class KeyOf, class Seen>
+				std::shared_ptr<Stream<E>> distinctWith(std::shared_ptr<Stream<E>> && source, KeyOf && keyOf, Seen && seen) {
+					using G = DistinctGen<StreamGen<std::shared_ptr<Stream<E>>>, std::decay_t<KeyOf>, std::decay_t<Seen>>;
+					return Stream<E>::Generate(G(StreamGen<std::shared_ptr<Stream<E>>>(std::move(source)), std::forward<KeyOf>(keyOf), std::forward<Seen>(seen)));
+				}
+			}
+
+			/**************************************************
+			 * The elements of `source` whose `keyOf(e)` has not
+			 * occurred before, in order. Keys are remembered in an
+			 * open-addressing hash set, so memory grows with the
+			 * number of distinct keys: for unbounded streams, see
+			 * `distinctApproxBy` and `distinctRecentBy`.
+			 *
+			 * Rejected elements are skipped iteratively, and cost
+			 * no cells of the result.
+			 **************************************************/
+			template<class E, class KeyOf>
+			std::shared_ptr<Stream<E>> distinctBy(std::shared_ptr<Stream<E>> source, KeyOf keyOf) {
+				return detail::distinctWith(std::move(source), std::move(keyOf), detail::OpenHashSet<detail::DistinctKeyT<E, KeyOf>>());
+			}
+
+			/// The elements of `source` which have not occurred before, in order. See `distinctBy`.
+			template<class E>
+			std::shared_ptr<Stream<E>> distinct(std::shared_ptr<Stream<E>> source) {
+				return distinctBy(std::move(source), detail::Identity());
+			}
+
+			/**************************************************
+			 * As `distinctBy`, but remembering keys in a
+			 * `ScalableBloomFilter`. No duplicate is ever emitted,
+			 * but each new key is wrongly dropped with probability
+			 * at most `falsePositiveRate`. Memory still grows with
+			 * the number of distinct keys, but at a few bytes
+			 * per key, rather than the size of the key.
+			 **************************************************/
+			template<class E, class KeyOf>
+			std::shared_ptr<Stream<E>> distinctApproxBy(std::shared_ptr<Stream<E>> source, KeyOf keyOf, double falsePositiveRate = 0.001, std::size_t initialCapacity = 1024) {
+				return detail::distinctWith(std::move(source), std::move(keyOf), ScalableBloomFilter<detail::DistinctKeyT<E, KeyOf>>(initialCapacity, falsePositiveRate));
+			}
+
+			template<class E>
+			std::shared_ptr<Stream<E>> distinctApprox(std::shared_ptr<Stream<E>> source, double falsePositiveRate = 0.001, std::size_t initialCapacity = 1024) {
+				return distinctApproxBy(std::move(source), detail::Identity(), falsePositiveRate, initialCapacity);
+			}
+
+			/**************************************************
+			 * As `distinctBy`, but only remembering recent keys,
+			 * in bounded memory: each key is forgotten after
+			 * between `capacity / 2` and `capacity` other distinct
+			 * keys have been seen since it last occurred. So a
+			 * repeat is dropped if it recurs soon enough, and new
+			 * keys are never dropped. Suits streams whose duplicates
+			 * arrive close together, such as retried deliveries.
+			 **************************************************/
+			template<class E, class KeyOf>
+			std::shared_ptr<Stream<E>> distinctRecentBy(std::shared_ptr<Stream<E>> source, KeyOf keyOf, std::size_t capacity) {
+				if(!capacity) {
+					throw std::invalid_argument("distinctRecentBy: the capacity must be positive");
+				}
+				return detail::distinctWith(std::move(source), std::move(keyOf), detail::GenerationalSet<detail::DistinctKeyT<E, KeyOf>>(capacity));
+			}
+
+			template<class E>
+			std::shared_ptr<Stream<E>> distinctRecent(std::shared_ptr<Stream<E>> source, std::size_t capacity) {
+				return distinctRecentBy(std::move(source), detail::Identity(), capacity);
+			}
+		}
+	}
+}
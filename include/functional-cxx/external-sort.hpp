@@ -0,0 +1,199 @@
+#pragma once
+/************************************************************************************
+ *
+ * Author: Thomas Dickerson
+ * Copyright: 2021, Geopipe, Inc.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ************************************************************************************/
+
+#include <algorithm>
+#include <cstddef>
+#include <deque>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <future>
+#include <memory>
+#include <optional>
+#include <stdexcept>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include <functional-cxx/merge-sorted.hpp>
+#include <functional-cxx/stream.hpp>
+#include <functional-cxx/support/generators.hpp>
+#include <functional-cxx/support/serialization.hpp>
+
+namespace com {
+	namespace geopipe {
+		/**************************************************
+		 * Tools for functional programming
+		 **************************************************/
+		namespace functional {
+			/// Tuning knobs for `externalSort`.
+			struct ExternalSortOptions {
+				std::size_t threads = 0; ///< Workers sorting and writing runs, besides the caller reading the input. Zero means `std::thread::hardware_concurrency()`.
+				std::size_t fanIn = 64; ///< The most runs merged at once. If there are more, they are first merged into longer runs, in passes.
+				std::size_t ioBufferSize = std::size_t(1) << 16; ///< Bytes of buffer per open run file.
+			};
+
+			/**************************************************
+			 * Internal implementation details
+			 **************************************************/
+			namespace detail {
+				/**************************************************
+				 * Write whatever `produce(sink)` passes to `sink` to a
+				 * new `SpillFile` in `directory`. Throws `std::runtime_error`
+				 * if the file cannot be written (e.g. the disk is full).
+				 **************************************************/
+				template<class E, class Serializer, class Produce>
+				std::shared_ptr<SpillFile> writeRun(const std::filesystem::path& directory, Serializer& serializer, std::size_t bufferSize, Produce && produce) {
+					auto file = std::make_shared<SpillFile>(directory, "functional-cxx-sort");
+					std::unique_ptr<char[]> buffer(new char[bufferSize]);
+					std::ofstream out;
+					out.rdbuf()->pubsetbuf(buffer.get(), std::streamsize(bufferSize));
+					out.open(file->path(), std::ios::binary | std::ios::trunc);
+					produce([&](const E& e){
+						serializer.write(out, e);
+					});
+					out.close();
+					if(!out) {
+						throw std::runtime_error("externalSort: failed writing " + file->path().string());
+					}
+					return file;
+				}
+
+				/// Yields the elements of a run written by `writeRun`, which is deleted once this is destroyed. A failed read throws, rather than ending the run.
+				template<class E, class Serializer>
+				class RunReader {
+					std::shared_ptr<SpillFile> file_;
+					std::unique_ptr<char[]> buffer_;
+					std::unique_ptr<std::ifstream> in_;
+					Serializer serializer_;
+				public:
+					RunReader(std::shared_ptr<SpillFile> file, const Serializer& serializer, std::size_t bufferSize)
+					: file_(std::move(file)), buffer_(new char[bufferSize]), in_(std::make_unique<std::ifstream>()), serializer_(serializer) {
+						in_->rdbuf()->pubsetbuf(buffer_.get(), std::streamsize(bufferSize));
+						in_->open(file_->path(), std::ios::binary);
+						if(!*in_) {
+							throw std::runtime_error("externalSort: failed reading " + file_->path().string());
+						}
+					}
+
+					std::optional<E> operator()() {
+						std::optional<E> e = serializer_.read(*in_);
+						if(!e && !in_->eof()) {
+							throw std::runtime_error("externalSort: failed reading " + file_->path().string());
+						}
+						return e;
+					}
+				};
+
+				template<class E, class Serializer>
+				std::vector<std::shared_ptr<Stream<E>>> readRuns(std::vector<std::shared_ptr<SpillFile>> && runs, const Serializer& serializer, std::size_t bufferSize) {
+					std::vector<std::shared_ptr<Stream<E>>> streams;
+					streams.reserve(runs.size());
+					for(auto& run : runs) {
+						streams.push_back(Stream<E>::Generate(RunReader<E, Serializer>(std::move(run), serializer, bufferSize)));
+					}
+					runs.clear();
+					return streams;
+				}
+			}
+
+			/**************************************************
+			 * Sort the finite `source`, which may be far larger than
+			 * memory, into a lazy `Stream`, by external merge sort.
+			 *
+			 * `source` is read in runs of at most `memoryBudget` bytes
+			 * (counting `sizeof(E)` per element, so types owning heap
+			 * memory should budget for that). Each run is sorted and
+			 * written to a temporary file in `tmpdir` by a pool of
+			 * workers, while the calling thread reads the next run;
+			 * so the budget is shared between the runs in flight. The
+			 * runs are then merged lazily with `mergeSorted` as the
+			 * result is forced, and each file is deleted as soon as
+			 * it has been read (or the result is released). If
+			 * `source` fits in a single run, nothing is written.
+			 *
+			 * Elements are written with `serializer`: by default
+			 * `BinarySerializer`, which requires a trivially copyable
+			 * `E`. The sort is not stable. Exceptions from the workers
+			 * (including `std::runtime_error` on I/O failure) are
+			 * rethrown here.
+			 **************************************************/
+			template<class E, class Compare = std::less<>, class Serializer = BinarySerializer<E>>
+			std::shared_ptr<Stream<E>> externalSort(std::shared_ptr<Stream<E>> && source, Compare cmp, std::size_t memoryBudget,
+			                                        std::filesystem::path tmpdir = std::filesystem::temp_directory_path(),
+			                                        Serializer serializer = Serializer(), const ExternalSortOptions& options = ExternalSortOptions()) {
+				using Runs = std::vector<std::shared_ptr<detail::SpillFile>>;
+				std::size_t threads = options.threads ? options.threads : std::max<std::size_t>(1, std::thread::hardware_concurrency());
+				std::size_t runLength = std::max<std::size_t>(1, memoryBudget / sizeof(E) / (threads + 1));
+				std::size_t bufferSize = std::max<std::size_t>(options.ioBufferSize, 1);
+				std::size_t fanIn = std::max<std::size_t>(options.fanIn, 2);
+
+				Runs runs;
+				std::deque<std::future<std::shared_ptr<detail::SpillFile>>> pending;
+				std::shared_ptr<Stream<E>> cell(std::move(source));
+				while(cell) {
+					std::vector<E> run;
+					run.reserve(runLength);
+					for(; cell && run.size() < runLength; cell = drop(std::move(cell), 1)) {
+						run.push_back(cell->head());
+					}
+					if(!cell && runs.empty() && pending.empty()) {
+						// Everything fits in memory.
+						std::sort(run.begin(), run.end(), cmp);
+						return Stream<E>::Generate([run = std::move(run), i = std::size_t(0)]() mutable -> std::optional<E> {
+							if(i == run.size()) {
+								return std::nullopt;
+							}
+							return std::move(run[i++]);
+						});
+					}
+					if(pending.size() >= threads) {
+						runs.push_back(pending.front().get());
+						pending.pop_front();
+					}
+					pending.push_back(std::async(std::launch::async, [run = std::move(run), cmp, serializer, &tmpdir, bufferSize]() mutable {
+						std::sort(run.begin(), run.end(), cmp);
+						return detail::writeRun<E>(tmpdir, serializer, bufferSize, [&](auto && sink){
+							for(const E& e : run) {
+								sink(e);
+							}
+						});
+					}));
+				}
+				for(auto& f : pending) {
+					runs.push_back(f.get());
+				}
+
+				while(runs.size() > fanIn) {
+					Runs merged;
+					for(std::size_t i = 0; i < runs.size(); i += fanIn) {
+						Runs group(std::make_move_iterator(runs.begin() + i), std::make_move_iterator(runs.begin() + std::min(runs.size(), i + fanIn)));
+						merged.push_back(detail::writeRun<E>(tmpdir, serializer, bufferSize, [&](auto && sink){
+							detail::consumeStream(mergeSorted(detail::readRuns<E>(std::move(group), serializer, bufferSize), cmp), sink);
+						}));
+					}
+					runs = std::move(merged);
+				}
+				return mergeSorted(detail::readRuns<E>(std::move(runs), serializer, bufferSize), std::move(cmp));
+			}
+		}
+	}
+}
@@ -0,0 +1,200 @@
+#pragma once
+/************************************************************************************
+ *
+ * Author: Thomas Dickerson
+ * Copyright: 2021, Geopipe, Inc.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ************************************************************************************/
+
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <optional>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include <functional-cxx/stream.hpp>
+#include <functional-cxx/support/generators.hpp>
+#include <functional-cxx/support/hashing.hpp>
+#include <functional-cxx/support/open-hash-table.hpp>
+
+namespace com {
+	namespace geopipe {
+		/**************************************************
+		 * Tools for functional programming
+		 **************************************************/
+		namespace functional {
+			/**************************************************
+			 * Internal implementation details
+			 **************************************************/
+			namespace detail {
+				/**************************************************
+				 * The build side of a hash join: every row, grouped by
+				 * key into one contiguous array, and a hash table from
+				 * each key to its group. Probing a key is a single
+				 * lookup, and its matches are then read sequentially.
+				 **************************************************/
+				template<class K, class R>
+				class JoinTable {
+					struct Group {
+						std::size_t begin;
+						std::size_t count;
+					};
+
+					OpenHashMap<K, Group> groups_;
+					std::vector<R> rows_;
+				public:
+					template<class KeyOf>
+					JoinTable(std::shared_ptr<Stream<R>> && build, KeyOf & keyOf) {
+						std::vector<R> rows;
+						std::vector<K> keys;
+						consumeStream(std::move(build), [&](const R& r){
+							keys.push_back(keyOf(r));
+							rows.push_back(r);
+						});
+						groups_.reserve(rows.size());
+						for(const K& k : keys) {
+							++groups_.tryEmplace(k, Group{0, 0}).first->count;
+						}
+						// Assign each group its range, then reuse `count` as the group's fill cursor.
+						std::size_t offset = 0;
+						groups_.forEach([&](const K&, Group& g){
+							g.begin = offset;
+							offset += g.count;
+							g.count = 0;
+						});
+						std::vector<std::size_t> order(rows.size());
+						for(std::size_t i = 0; i < rows.size(); ++i) {
+							Group& g = *groups_.find(keys[i]);
+							order[g.begin + g.count++] = i;
+						}
+						rows_.reserve(rows.size());
+						for(std::size_t i : order) {
+							rows_.push_back(std::move(rows[i]));
+						}
+					}
+
+					/// The rows with key `k`, as `[first, last)` indices into `row`.
+					std::pair<std::size_t, std::size_t> find(const K& k) const {
+						const Group* g = groups_.find(k);
+						return g ? std::make_pair(g->begin, g->begin + g->count) : std::make_pair(std::size_t(0), std::size_t(0));
+					}
+
+					const R& row(std::size_t i) const {
+						return rows_[i];
+					}
+				};
+			}
+
+			/**************************************************
+			 * The inner equi-join of `probe` with `build`: a lazy
+			 * `Stream` of `(l, r)` for each `l` of `probe` and `r`
+			 * of `build` with `leftKey(l) == rightKey(r)`, in the
+			 * order of `probe`, and then of `build`.
+			 *
+			 * `build` is consumed and materialized up front, so it
+			 * should be the smaller side. Its rows are grouped by key
+			 * into one contiguous array (see `detail::JoinTable`), so
+			 * each probe costs one hash lookup and then a sequential
+			 * scan of its matches. `probe` is consumed lazily, and
+			 * its non-matching elements cost no cells of the result.
+			 *
+			 * Both key functions must return the same (hashable) type.
+			 **************************************************/
+			template<class L, class R, class LeftKey, class RightKey>
+			std::shared_ptr<Stream<std::pair<L, R>>> hashJoin(std::shared_ptr<Stream<L>> probe, std::shared_ptr<Stream<R>> build, LeftKey leftKey, RightKey rightKey) {
+				using K = std::decay_t<std::invoke_result_t<RightKey&, const R&>>;
+				static_assert(std::is_convertible_v<std::invoke_result_t<LeftKey&, const L&>, const K&>, "hashJoin: leftKey and rightKey must return the same type");
+				return Stream<std::pair<L, R>>::Generate([input = detail::StreamGen<std::shared_ptr<Stream<L>>>(std::move(probe)), table = detail::JoinTable<K, R>(std::move(build), rightKey), leftKey = std::move(leftKey),
+				                                          current = std::optional<L>(), next = std::size_t(0), last = std::size_t(0)]() mutable -> std::optional<std::pair<L, R>> {
+					while(next == last) {
+						current = input();
+						if(!current) {
+							return std::nullopt;
+						}
+						std::tie(next, last) = table.find(leftKey(std::as_const(*current)));
+					}
+					return std::make_pair(*current, table.row(next++));
+				});
+			}
+
+			/**************************************************
+			 * The inner equi-join of two `Stream`s each sorted by key
+			 * (ascending under `compare`): a lazy `Stream` of `(l, r)`
+			 * for each `l` of `left` and `r` of `right` with equivalent
+			 * `leftKey(l)` and `rightKey(r)`, in order of key, then of
+			 * `left`, then of `right`.
+			 *
+			 * Each side's `tail` is forced at most once per element,
+			 * and neither is forced further ahead than needed. Runs of
+			 * duplicate keys on the right are buffered (once), and
+			 * replayed against each left element with that key, so
+			 * memory is bounded by the longest such run.
+			 *
+			 * `compare` must accept either key type on either side.
+			 **************************************************/
+			template<class L, class R, class LeftKey, class RightKey, class Compare = std::less<>>
+			std::shared_ptr<Stream<std::pair<L, R>>> mergeJoin(std::shared_ptr<Stream<L>> left, std::shared_ptr<Stream<R>> right, LeftKey leftKey, RightKey rightKey, Compare compare = Compare()) {
+				using K = std::decay_t<std::invoke_result_t<LeftKey&, const L&>>;
+				/// Mutable state of the join, for the generator below.
+				struct State {
+					detail::StreamGen<std::shared_ptr<Stream<L>>> left;
+					detail::StreamGen<std::shared_ptr<Stream<R>>> right;
+					LeftKey leftKey;
+					RightKey rightKey;
+					Compare compare;
+					std::optional<L> current; ///< The left element being joined.
+					std::optional<R> lookahead; ///< The next right element not in `group`.
+					std::vector<R> group; ///< The right elements whose key is `groupKey`.
+					std::optional<K> groupKey;
+					std::size_t next; ///< Index into `group`.
+				};
+				State state{detail::StreamGen<std::shared_ptr<Stream<L>>>(std::move(left)), detail::StreamGen<std::shared_ptr<Stream<R>>>(std::move(right)),
+				            std::move(leftKey), std::move(rightKey), std::move(compare), std::nullopt, std::nullopt, {}, std::nullopt, 0};
+				state.lookahead = state.right();
+				return Stream<std::pair<L, R>>::Generate([state = std::move(state)]() mutable -> std::optional<std::pair<L, R>> {
+					while(!state.current || state.next == state.group.size()) {
+						state.current = state.left();
+						if(!state.current) {
+							return std::nullopt;
+						}
+						state.next = 0;
+						K k = state.leftKey(std::as_const(*state.current));
+						if(state.groupKey && !state.compare(*state.groupKey, k) && !state.compare(k, *state.groupKey)) {
+							continue; // Replay the group against this element.
+						}
+						state.group.clear();
+						while(state.lookahead && state.compare(state.rightKey(std::as_const(*state.lookahead)), k)) {
+							state.lookahead = state.right();
+						}
+						while(state.lookahead && !state.compare(k, state.rightKey(std::as_const(*state.lookahead)))) {
+							state.group.push_back(std::move(*state.lookahead));
+							state.lookahead = state.right();
+						}
+						state.groupKey = std::move(k);
+						if(!state.lookahead && state.group.empty()) {
+							// Nothing on the right can match any later element.
+							state.left = detail::StreamGen<std::shared_ptr<Stream<L>>>(nullptr);
+						}
+					}
+					return std::make_pair(*state.current, state.group[state.next++]);
+				});
+			}
+		}
+	}
+}
@@ -0,0 +1,146 @@
+#pragma once
+/************************************************************************************
+ *
+ * Author: Thomas Dickerson
+ * Copyright: 2021, Geopipe, Inc.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ************************************************************************************/
+
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <optional>
+#include <utility>
+#include <vector>
+
+#include <functional-cxx/stream.hpp>
+
+namespace com {
+	namespace geopipe {
+		/**************************************************
+		 * Tools for functional programming
+		 **************************************************/
+		namespace functional {
+			/**************************************************
+			 * Internal implementation details
+			 **************************************************/
+			namespace detail {
+				/**************************************************
+				 * Incremental quicksort (Paredes & Navarro, 2006).
+				 *
+				 * `bounds_` is a stack of segment boundaries: every element
+				 * before a boundary compares less than or equal to every element
+				 * after it, and the top of the stack is the end of the segment
+				 * containing the next element to emit. We only ever partition
+				 * that segment, so obtaining the first `k` elements in order
+				 * costs expected O(n + k log k).
+				 *
+				 * Partitioning is three-way, so runs of equal elements are
+				 * finalized at once rather than degrading to quadratic time.
+				 **************************************************/
+				template<class E, class Compare>
+				class IncrementalSort {
+					std::vector<E> items_;
+					std::vector<std::size_t> bounds_;
+					std::size_t next_; ///< Index of the next element to emit.
+					std::size_t final_; ///< Elements before this index are in their sorted position.
+					Compare cmp_;
+
+					std::size_t medianOfThree(std::size_t a, std::size_t b, std::size_t c) {
+						if(cmp_(items_[a], items_[b])) {
+							return cmp_(items_[b], items_[c]) ? b : (cmp_(items_[a], items_[c]) ? c : a);
+						} else {
+							return cmp_(items_[a], items_[c]) ? a : (cmp_(items_[b], items_[c]) ? c : b);
+						}
+					}
+
+					/// Dutch national flag partition of `[lo, hi)` into `< pivot`, `== pivot`, `> pivot`.
+					std::pair<std::size_t, std::size_t> partition(std::size_t lo, std::size_t hi) {
+						using std::swap;
+						swap(items_[lo], items_[medianOfThree(lo, lo + (hi - lo) / 2, hi - 1)]);
+						E pivot(items_[lo]);
+						std::size_t lt = lo, i = lo + 1, gt = hi;
+						while(i < gt) {
+							if(cmp_(items_[i], pivot)) {
+								swap(items_[lt++], items_[i++]);
+							} else if(cmp_(pivot, items_[i])) {
+								swap(items_[i], items_[--gt]);
+							} else {
+								++i;
+							}
+						}
+						return {lt, gt};
+					}
+
+					void settle() {
+						while(next_ >= final_) {
+							std::size_t top = bounds_.back();
+							if(top - next_ == 1) {
+								final_ = top;
+								bounds_.pop_back();
+								return;
+							}
+							auto [lt, gt] = partition(next_, top);
+							if(gt < top) {
+								bounds_.push_back(gt);
+							}
+							if(lt == next_) {
+								final_ = gt;
+								bounds_.pop_back();
+								return;
+							}
+							bounds_.push_back(lt);
+						}
+					}
+				public:
+					IncrementalSort(std::vector<E> && items, Compare && cmp)
+					: items_(std::move(items)), bounds_{items_.size()}, next_(0), final_(0), cmp_(std::move(cmp)) {}
+
+					std::optional<E> operator()() {
+						if(next_ == items_.size()) {
+							return std::nullopt;
+						}
+						settle();
+						return std::move(items_[next_++]);
+					}
+				};
+			}
+
+			/**************************************************
+			 * Obtain a sorted view of the finite `Stream` `stream`
+			 * which only pays for as much sorting as is consumed.
+			 *
+			 * The input is materialized once (consuming `stream`,
+			 * so move it in to avoid retaining the input cells), after
+			 * which the first `k` elements of the output cost expected
+			 * O(n + k log k) in total. The sort is not stable.
+			 *
+			 * @warning `stream` must be finite.
+			 **************************************************/
+			template<class E, class Compare = std::less<E>>
+			std::shared_ptr<Stream<E>> lazySorted(std::shared_ptr<Stream<E>> stream, Compare cmp = Compare()) {
+				std::vector<E> items;
+				for(; stream; stream = stream->tail()) {
+					items.push_back(stream->head());
+				}
+				auto sorter = std::make_unique<detail::IncrementalSort<E, Compare>>(std::move(items), std::move(cmp));
+				return Stream<E>::Generate([sorter = std::move(sorter)](){
+					return (*sorter)();
+				});
+			}
+		}
+	}
+}
@@ -0,0 +1,344 @@
+#pragma once
+/************************************************************************************
+ *
+ * Author: Thomas Dickerson
+ * Copyright: 2021, Geopipe, Inc.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ************************************************************************************/
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <stdexcept>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include <functional-cxx/memoize.hpp>
+#include <functional-cxx/support/memory-hacks.hpp>
+
+namespace com {
+	namespace geopipe {
+		/**************************************************
+		 * Tools for functional programming
+		 **************************************************/
+		namespace functional {
+			/// Tuning knobs for `LazyTable`.
+			struct TableOptions {
+				std::size_t tileSize = 64; ///< Side length of the square tiles `LazyTable::evaluate` schedules.
+				std::size_t threads = 0; ///< Workers for `LazyTable::evaluate`, including the caller. Zero means `std::thread::hardware_concurrency()`.
+				/**************************************************
+				 * As for `MemoOptions::maxNativeDepth`, when forcing on demand.
+				 * A dependency chain deeper than this is deferred by throwing
+				 * an exception through at most this many frames of
+				 * `Recurrence`, which are re-run once the deferred cell is
+				 * forced. Each cell is deferred at most once, so a chain of
+				 * `L` cells costs `O(L)` re-run frames and `O(L)` frames
+				 * unwound by exceptions; but unwinding a frame costs far
+				 * more than making one, so prefer `evaluate` when most of
+				 * a large table will be needed anyway.
+				 **************************************************/
+				std::size_t maxNativeDepth = 1024;
+			};
+
+			/**************************************************
+			 * A lazy, memoized 2-D dynamic programming table: this
+			 * is to a recurrence over `(i, j)` what `Stream::tail`
+			 * is to a recurrence over a list.
+			 *
+			 * Cell `(i, j)` is defined as `f(self, i, j)`, where `self(i', j')`
+			 * returns a neighbouring cell, forcing it if necessary.
+			 * Cells live in one flat row-major array, so neighbours
+			 * share cache lines, unlike recursive memoization through
+			 * a hash table.
+			 *
+			 * There are two ways to force cells:
+			 * - `operator()` forces a cell and just the cells it
+			 *   (transitively) depends on. As with `Memoized`, deep
+			 *   dependency chains are handled with an explicit work
+			 *   stack rather than the native one.
+			 * - `evaluate` eagerly forces every cell. This requires
+			 *   that cell `(i, j)` only depends on cells `(i', j')`
+			 *   with `i' <= i` and `j' <= j` (as in edit distance, LCS,
+			 *   alignment scoring, ...), so not, e.g., on `(i - 1, j + 1)`.
+			 *   It splits the table into square tiles
+			 *   and evaluates each tile in row-major order once the tiles
+			 *   above and to its left are done, so whole anti-diagonals
+			 *   of tiles run in parallel, and each tile's working set
+			 *   stays in cache.
+			 *
+			 * Cells already forced are never recomputed, so the two may be mixed.
+			 * @warning `operator()` is not thread-safe, and must not
+			 * be called concurrently with `evaluate`.
+			 **************************************************/
+			template<class T, class Recurrence>
+			class LazyTable {
+				std::size_t rows_;
+				std::size_t cols_;
+				std::unique_ptr<detail::AlignedFor<T>[]> cells_;
+				std::unique_ptr<std::atomic<std::uint8_t>[]> forced_;
+				Recurrence f_;
+				TableOptions options_;
+
+				struct Index {
+					std::size_t i;
+					std::size_t j;
+				};
+			public:
+				/// The handle through which `Recurrence` reads other cells.
+				class Self {
+					friend class LazyTable;
+					LazyTable *table_;
+					std::vector<Index> *deferred_; ///< Null when evaluating eagerly.
+					std::size_t depth_;
+
+					Self(LazyTable *table, std::vector<Index> *deferred, std::size_t depth)
+					: table_(table), deferred_(deferred), depth_(depth) {}
+				public:
+					const T& operator()(std::size_t i, std::size_t j) const {
+						return table_->demand(i, j, deferred_, depth_ + 1);
+					}
+
+					std::size_t rows() const {
+						return table_->rows_;
+					}
+
+					std::size_t cols() const {
+						return table_->cols_;
+					}
+				};
+			private:
+				T& cell(std::size_t k) {
+					return *std::launder(reinterpret_cast<T*>(&cells_[k]));
+				}
+
+				void checkBounds(std::size_t i, std::size_t j) const {
+					if(i >= rows_ || j >= cols_) {
+						throw std::out_of_range("LazyTable: cell index out of range");
+					}
+				}
+
+				const T& compute(std::size_t i, std::size_t j, const Self& self) {
+					std::size_t k = i * cols_ + j;
+					new (&cells_[k]) T(f_(self, i, j));
+					forced_[k].store(1, std::memory_order_release);
+					return cell(k);
+				}
+
+				const T& demand(std::size_t i, std::size_t j, std::vector<Index> *deferred, std::size_t depth) {
+					checkBounds(i, j);
+					std::size_t k = i * cols_ + j;
+					if(forced_[k].load(std::memory_order_acquire)) {
+						return cell(k);
+					}
+					if(!deferred) {
+						throw std::logic_error("LazyTable::evaluate: cell (i, j) depends on a cell (i', j') without i' <= i and j' <= j");
+					}
+					if(depth > options_.maxNativeDepth) {
+						deferred->push_back(Index{i, j});
+						throw detail::DeferredCall();
+					}
+					return compute(i, j, Self(this, deferred, depth));
+				}
+
+				/// Evaluate tile `(ti, tj)` in row-major order.
+				void evaluateTile(std::size_t ti, std::size_t tj) {
+					std::size_t b = options_.tileSize;
+					std::size_t iEnd = std::min(rows_, (ti + 1) * b);
+					std::size_t jEnd = std::min(cols_, (tj + 1) * b);
+					Self self(this, nullptr, 0);
+					for(std::size_t i = ti * b; i < iEnd; ++i) {
+						for(std::size_t j = tj * b; j < jEnd; ++j) {
+							if(!forced_[i * cols_ + j].load(std::memory_order_relaxed)) {
+								compute(i, j, self);
+							}
+						}
+					}
+				}
+			public:
+				LazyTable(std::size_t rows, std::size_t cols, Recurrence f, const TableOptions& options = TableOptions())
+				: rows_(rows), cols_(cols), cells_(new detail::AlignedFor<T>[rows * cols]),
+				  forced_(new std::atomic<std::uint8_t>[rows * cols]), f_(std::move(f)), options_(options) {
+					if(!options_.tileSize) {
+						options_.tileSize = 1;
+					}
+					for(std::size_t k = 0; k < rows_ * cols_; ++k) {
+						forced_[k].store(0, std::memory_order_relaxed);
+					}
+				}
+
+				LazyTable(const LazyTable&) = delete;
+				LazyTable& operator=(const LazyTable&) = delete;
+
+				~LazyTable() {
+					if(cells_) {
+						for(std::size_t k = 0; k < rows_ * cols_; ++k) {
+							if(forced_[k].load(std::memory_order_relaxed)) {
+								cell(k).~T();
+							}
+						}
+					}
+				}
+
+				std::size_t rows() const {
+					return rows_;
+				}
+
+				std::size_t cols() const {
+					return cols_;
+				}
+
+				bool forced(std::size_t i, std::size_t j) const {
+					checkBounds(i, j);
+					return forced_[i * cols_ + j].load(std::memory_order_acquire);
+				}
+
+				/// Force cell `(i, j)`, and whatever it depends on.
+				const T& operator()(std::size_t i, std::size_t j) {
+					checkBounds(i, j);
+					std::vector<Index> deferred{Index{i, j}};
+					for(;;) {
+						Index top = deferred.back();
+						try {
+							const T& result = demand(top.i, top.j, &deferred, 0);
+							deferred.pop_back();
+							if(deferred.empty()) {
+								return result;
+							}
+						} catch(const detail::DeferredCall&) {
+							// A deeper dependency is now on top of `deferred`; force it first.
+						}
+					}
+				}
+
+				/**************************************************
+				 * Force every cell, in parallel, scheduling tiles as
+				 * a dataflow graph: each tile waits on a count of its
+				 * unfinished upper and left neighbours, and the tile
+				 * completing the count makes it ready.
+				 * Reading a cell outside the contract in the class
+				 * documentation throws `std::logic_error`, unless that
+				 * cell happens to be forced already, so do not rely on it.
+				 * The first exception thrown by the recurrence is
+				 * rethrown once all workers have stopped.
+				 **************************************************/
+				void evaluate() {
+					std::size_t b = options_.tileSize;
+					std::size_t tileRows = (rows_ + b - 1) / b;
+					std::size_t tileCols = (cols_ + b - 1) / b;
+					std::size_t tiles = tileRows * tileCols;
+					if(!tiles) {
+						return;
+					}
+					std::unique_ptr<std::atomic<std::uint8_t>[]> waiting(new std::atomic<std::uint8_t>[tiles]);
+					for(std::size_t ti = 0; ti < tileRows; ++ti) {
+						for(std::size_t tj = 0; tj < tileCols; ++tj) {
+							waiting[ti * tileCols + tj].store(std::uint8_t((ti > 0) + (tj > 0)), std::memory_order_relaxed);
+						}
+					}
+
+					std::mutex mutex;
+					std::condition_variable cv;
+					std::deque<std::size_t> ready{0};
+					std::size_t done = 0;
+					std::exception_ptr error;
+
+					auto work = [&](){
+						std::unique_lock<std::mutex> lock(mutex);
+						for(;;) {
+							cv.wait(lock, [&](){
+								return !ready.empty() || done == tiles || error;
+							});
+							if(done == tiles || error) {
+								return;
+							}
+							std::size_t t = ready.front();
+							ready.pop_front();
+							lock.unlock();
+							std::size_t ti = t / tileCols, tj = t % tileCols;
+							std::exception_ptr failure;
+							try {
+								evaluateTile(ti, tj);
+							} catch(...) {
+								failure = std::current_exception();
+							}
+							std::size_t unblocked[2];
+							std::size_t n = 0;
+							if(!failure) {
+								if(tj + 1 < tileCols && waiting[t + 1].fetch_sub(1, std::memory_order_acq_rel) == 1) {
+									unblocked[n++] = t + 1;
+								}
+								if(ti + 1 < tileRows && waiting[t + tileCols].fetch_sub(1, std::memory_order_acq_rel) == 1) {
+									unblocked[n++] = t + tileCols;
+								}
+							}
+							lock.lock();
+							if(failure && !error) {
+								error = failure;
+							}
+							++done;
+							ready.insert(ready.end(), unblocked, unblocked + n);
+							if(n > 1 || done == tiles || error) {
+								cv.notify_all();
+							} else if(n == 1) {
+								cv.notify_one();
+							}
+						}
+					};
+
+					std::size_t threads = options_.threads ? options_.threads : std::max<std::size_t>(1, std::thread::hardware_concurrency());
+					threads = std::min(threads, std::min(tileRows, tileCols));
+					std::vector<std::thread> pool;
+					pool.reserve(threads - 1);
+					for(std::size_t k = 1; k < threads; ++k) {
+						pool.emplace_back(work);
+					}
+					work();
+					for(auto& t : pool) {
+						t.join();
+					}
+					if(error) {
+						std::rethrow_exception(error);
+					}
+				}
+			};
+
+			/**************************************************
+			 * Create a `rows` by `cols` `LazyTable` of `T`,
+			 * with cell `(i, j)` defined as `f(self, i, j)`.
+			 * For example, edit distance:
+			 * ~~~
+			 * auto d = lazyTable<std::size_t>(a.size() + 1, b.size() + 1, [&](auto& d, std::size_t i, std::size_t j) -> std::size_t {
+			 *     if(!i || !j) return i + j;
+			 *     return std::min({d(i - 1, j) + 1, d(i, j - 1) + 1, d(i - 1, j - 1) + (a[i - 1] != b[j - 1])});
+			 * });
+			 * d.evaluate(); // Optional: otherwise d(a.size(), b.size()) forces what it needs.
+			 * ~~~
+			 **************************************************/
+			template<class T, class Recurrence>
+			LazyTable<T, Recurrence> lazyTable(std::size_t rows, std::size_t cols, Recurrence f, const TableOptions& options = TableOptions()) {
+				return LazyTable<T, Recurrence>(rows, cols, std::move(f), options);
+			}
+		}
+	}
+}
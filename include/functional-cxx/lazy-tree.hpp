@@ -0,0 +1,381 @@
+#pragma once
+/************************************************************************************
+ *
+ * Author: Thomas Dickerson
+ * Copyright: 2021, Geopipe, Inc.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ************************************************************************************/
+
+#include <boost/variant.hpp>
+#include <cstddef>
+#include <deque>
+#include <limits>
+#include <memory>
+#include <optional>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include <functional-cxx/stream.hpp>
+#include <functional-cxx/support/memory-hacks.hpp>
+#include <functional-cxx/support/unique-function.hpp>
+
+namespace com {
+	namespace geopipe {
+		/**************************************************
+		 * Tools for functional programming
+		 **************************************************/
+		namespace functional {
+			/**************************************************
+			 * Implements a lazy rose tree: a node with a `head`,
+			 * and a memoized, lazily computed `Stream` of children.
+			 *
+			 * This is to trees what `Stream` is to lists: the
+			 * children of a node are only computed when they are first
+			 * requested, and then saved, so search algorithms
+			 * (e.g. alpha-beta) only pay to evaluate the subtrees
+			 * they actually visit. Since the children are themselves
+			 * a `Stream`, even a node's later siblings are only
+			 * computed on demand.
+			 *
+			 * The traversals below (`depthFirst`, `breadthFirst`,
+			 * `iterativeDeepening`) produce `Stream`s of `Visit`s and
+			 * run iteratively, using constant native stack regardless
+			 * of the depth of the tree.
+			 *
+			 * @warning As with `Stream`, retaining the root retains
+			 * every node which has been forced beneath it.
+			 **************************************************/
+			template<class E>
+			class LazyTree : public std::enable_shared_from_this<LazyTree<E>> {
+			public:
+				using TreeT = std::shared_ptr<LazyTree<E>>; ///< We consider a "true" tree to be a `std::shared_ptr<LazyTree>`
+				using ChildrenT = std::shared_ptr<Stream<TreeT>>;
+			private:
+				using F = detail::UniqueFunction<ChildrenT()>; ///< A functor computing the children
+				E head_; ///< Storage for the label of this node
+				/// Combined storage for thunk or memoized children, `mutable` for the same reasons as `Stream::tail_`.
+				mutable boost::variant<ChildrenT, F> children_;
+
+				/// @pre This constructor should only be invoked from `LazyTree::makeShared`.
+				template<typename A1, typename A2>
+				LazyTree(A1 && e, A2 && c)
+				: head_(std::forward<A1>(e)), children_(std::forward<A2>(c)) {}
+
+				/// See `Stream::makeShared`.
+				template<typename A1, typename A2>
+				static TreeT makeShared(A1 && a1, A2 && a2) {
+					struct EnableMakeShared : LazyTree<E> {
+						EnableMakeShared(A1 && a1, A2 && a2) : LazyTree<E>(std::forward<A1>(a1), std::forward<A2>(a2)) {}
+					};
+
+					return std::make_shared<EnableMakeShared>(std::forward<A1>(a1), std::forward<A2>(a2));
+				}
+
+				/// Whether `p` is the only reference to its node, for the destructor.
+				template<class P>
+				static bool unique(const P& p) {
+					if(p.use_count() != 1) {
+						return false;
+					}
+					// `use_count` is a relaxed load: synchronize with whichever thread released its reference last,
+					// since we are about to read (and dismantle) state it may have written, e.g. in `parallelDepthFirst`.
+					// Releasing a copy does so with an acquire-release decrement, which (unlike a fence) ThreadSanitizer understands.
+					P(p).reset();
+					return true;
+				}
+			public:
+				/*****************************************************************
+				 * Unlike `Stream`, a `LazyTree` reclaims its forced descendants
+				 * iteratively, so dropping a deep tree cannot overflow the stack.
+				 * Subtrees (and sibling lists) still shared elsewhere are left intact.
+				 *****************************************************************/
+				~LazyTree() {
+					if(children_.which()) {
+						return;
+					}
+					std::vector<ChildrenT> pending;
+					pending.push_back(std::move(boost::get<ChildrenT>(children_)));
+					while(!pending.empty()) {
+						ChildrenT cell = std::move(pending.back());
+						pending.pop_back();
+						while(cell && unique(cell)) {
+							const TreeT& child = cell->head_;
+							if(unique(child) && !child->children_.which()) {
+								pending.push_back(std::move(boost::get<ChildrenT>(child->children_)));
+							}
+							if(cell->tail_.which()) {
+								break;
+							}
+							// Detach the rest of the list, so dropping `cell` only frees one node.
+							ChildrenT next = std::move(boost::get<ChildrenT>(cell->tail_));
+							cell = std::move(next);
+						}
+					}
+				}
+
+				/// Only `const`-access to the `head_` is permitted.
+				const E& head() const {
+					return head_;
+				}
+
+				/*****************************************************************
+				 * Force the children thunk, or access the memoized result.
+				 * @warning Like `Stream::tail`, this is not thread-safe.
+				 *****************************************************************/
+				const ChildrenT& children() const {
+					if(children_.which()) {
+						detail::emplace(children_, boost::get<F>(children_)());
+					}
+					return boost::get<ChildrenT>(children_);
+				}
+
+				/*****************************************************************
+				 * Create a new node labelled `e`.
+				 * @arg c may be _either_ a thunk returning `LazyTree::ChildrenT`
+				 * or an actual `LazyTree::ChildrenT`.
+				 *****************************************************************/
+				template<typename A1, typename A2>
+				static TreeT Node(A1 && e, A2 && c) {
+					return makeShared(std::forward<A1>(e), std::forward<A2>(c));
+				}
+
+				/// Create a node with no children.
+				template<typename A1>
+				static TreeT Leaf(A1 && e) {
+					return makeShared(std::forward<A1>(e), ChildrenT(nullptr));
+				}
+
+				/*****************************************************************
+				 * Grow a tree from `root` by repeatedly applying `expand`,
+				 * which maps a label to a `Stream` of its children's labels
+				 * (or `Stream::Nil()` for a leaf).
+				 * `expand` is only invoked for nodes whose children are forced.
+				 *****************************************************************/
+				template<class Expand>
+				static TreeT Unfold(E root, Expand expand) {
+					return Node(std::move(root), [root = root, expand]() mutable -> ChildrenT {
+						auto labels = expand(root);
+						if(!labels) {
+							return nullptr;
+						}
+						return labels->map([expand](const E& label) {
+							return Unfold(label, expand);
+						});
+					});
+				}
+			};
+
+			/// A node reached by a traversal, and its depth below the traversal's root.
+			template<class E>
+			struct Visit {
+				typename LazyTree<E>::TreeT node;
+				std::size_t depth;
+			};
+
+			/// The default pruning hook: always descend.
+			struct NoPrune {
+				template<class E>
+				bool operator()(const E&, std::size_t) const {
+					return false;
+				}
+			};
+
+			/**************************************************
+			 * Internal implementation details
+			 **************************************************/
+			namespace detail {
+				/// A cursor over one node's children, which forces each sibling only when it is reached.
+				template<class E>
+				struct SiblingCursor {
+					typename LazyTree<E>::ChildrenT cell;
+					bool started;
+					std::size_t depth;
+
+					typename LazyTree<E>::TreeT next() {
+						if(started) {
+							cell = cell->tail();
+						}
+						started = true;
+						return cell ? cell->head() : nullptr;
+					}
+				};
+
+				/// A cursor over the single-element "sibling list" containing just `root`.
+				template<class E>
+				SiblingCursor<E> rootCursor(typename LazyTree<E>::TreeT root) {
+					using ChildStream = Stream<typename LazyTree<E>::TreeT>;
+					return SiblingCursor<E>{root ? ChildStream::Cell(std::move(root), ChildStream::Nil()) : nullptr, false, 0};
+				}
+
+				/**************************************************
+				 * Generator for `depthFirst`, and each round of
+				 * `iterativeDeepening`.
+				 *
+				 * The children of the most recently emitted node are
+				 * only forced (and `prune` only consulted) when the next
+				 * element is requested, so a consumer may update whatever
+				 * state `prune` inspects (e.g. alpha-beta bounds) in between.
+				 * Nodes shallower than `emitFrom` are traversed but not
+				 * emitted, and nodes at `maxDepth` are not expanded.
+				 **************************************************/
+				template<class E, class Prune>
+				class DepthFirstF {
+					std::vector<SiblingCursor<E>> stack_;
+					std::optional<Visit<E>> unexpanded_;
+					Prune prune_;
+					std::size_t emitFrom_;
+					std::size_t maxDepth_;
+
+					void expand(const Visit<E> &v) {
+						if(v.depth < maxDepth_ && !prune_(v.node->head(), v.depth)) {
+							if(const auto& kids = v.node->children()) {
+								stack_.push_back(SiblingCursor<E>{kids, false, v.depth + 1});
+							}
+						}
+					}
+				public:
+					DepthFirstF(typename LazyTree<E>::TreeT root, Prune prune, std::size_t emitFrom, std::size_t maxDepth)
+					: stack_{rootCursor<E>(std::move(root))}, prune_(std::move(prune)), emitFrom_(emitFrom), maxDepth_(maxDepth) {}
+
+					std::optional<Visit<E>> operator()() {
+						if(unexpanded_) {
+							expand(*unexpanded_);
+							unexpanded_.reset();
+						}
+						while(!stack_.empty()) {
+							SiblingCursor<E>& top = stack_.back();
+							std::size_t depth = top.depth;
+							if(auto child = top.next()) {
+								Visit<E> v{std::move(child), depth};
+								if(depth >= emitFrom_) {
+									unexpanded_ = v;
+									return v;
+								}
+								expand(v);
+							} else {
+								stack_.pop_back();
+							}
+						}
+						return std::nullopt;
+					}
+				};
+
+				/// Generator for `breadthFirst`. Expansion is deferred as in `DepthFirstF`.
+				template<class E, class Prune>
+				class BreadthFirstF {
+					std::deque<SiblingCursor<E>> queue_;
+					std::optional<Visit<E>> unexpanded_;
+					Prune prune_;
+				public:
+					BreadthFirstF(typename LazyTree<E>::TreeT root, Prune prune)
+					: queue_{rootCursor<E>(std::move(root))}, prune_(std::move(prune)) {}
+
+					std::optional<Visit<E>> operator()() {
+						if(unexpanded_) {
+							if(!prune_(unexpanded_->node->head(), unexpanded_->depth)) {
+								if(const auto& kids = unexpanded_->node->children()) {
+									queue_.push_back(SiblingCursor<E>{kids, false, unexpanded_->depth + 1});
+								}
+							}
+							unexpanded_.reset();
+						}
+						while(!queue_.empty()) {
+							std::size_t depth = queue_.front().depth;
+							if(auto child = queue_.front().next()) {
+								unexpanded_ = Visit<E>{std::move(child), depth};
+								return unexpanded_;
+							}
+							queue_.pop_front();
+						}
+						return std::nullopt;
+					}
+				};
+
+				/**************************************************
+				 * Generator for `iterativeDeepening`: successive rounds
+				 * of `DepthFirstF`, each emitting only the nodes at its
+				 * depth limit, until a round finds none.
+				 **************************************************/
+				template<class E, class Prune>
+				class IterativeDeepeningF {
+					typename LazyTree<E>::TreeT root_;
+					Prune prune_;
+					std::size_t limit_;
+					std::size_t maxDepth_;
+					bool found_;
+					DepthFirstF<E, Prune> round_;
+				public:
+					IterativeDeepeningF(typename LazyTree<E>::TreeT root, Prune prune, std::size_t maxDepth)
+					: root_(root), prune_(prune), limit_(0), maxDepth_(maxDepth), found_(false), round_(std::move(root), std::move(prune), 0, 0) {}
+
+					std::optional<Visit<E>> operator()() {
+						for(;;) {
+							if(auto v = round_()) {
+								found_ = true;
+								return v;
+							}
+							if(!found_ || limit_ >= maxDepth_) {
+								return std::nullopt;
+							}
+							found_ = false;
+							++limit_;
+							round_ = DepthFirstF<E, Prune>(root_, prune_, limit_, limit_);
+						}
+					}
+				};
+			}
+
+			/**************************************************
+			 * Preorder depth-first traversal of `root`, as a `Stream`.
+			 *
+			 * @arg prune is consulted as `prune(head, depth)` just before
+			 * a node's children would be forced, i.e. when the element
+			 * _after_ that node is requested; returning `true` skips the
+			 * whole subtree beneath it without forcing it.
+			 **************************************************/
+			template<class E, class Prune = NoPrune>
+			std::shared_ptr<Stream<Visit<E>>> depthFirst(typename LazyTree<E>::TreeT root, Prune prune = Prune()) {
+				return Stream<Visit<E>>::Generate(detail::DepthFirstF<E, Prune>(std::move(root), std::move(prune), 0, std::numeric_limits<std::size_t>::max()));
+			}
+
+			/**************************************************
+			 * Level-order traversal of `root`, as a `Stream`.
+			 * Memory is proportional to the number of partially
+			 * visited sibling lists, not to the width of a level.
+			 * `prune` behaves as for `depthFirst`.
+			 **************************************************/
+			template<class E, class Prune = NoPrune>
+			std::shared_ptr<Stream<Visit<E>>> breadthFirst(typename LazyTree<E>::TreeT root, Prune prune = Prune()) {
+				return Stream<Visit<E>>::Generate(detail::BreadthFirstF<E, Prune>(std::move(root), std::move(prune)));
+			}
+
+			/**************************************************
+			 * Iterative-deepening traversal of `root`, as a `Stream`:
+			 * nodes are emitted in level order, but each level is found
+			 * by a depth-limited `depthFirst`, so the traversal's own
+			 * bookkeeping is proportional to the depth rather than the
+			 * width of the tree. Since children are memoized, repeated
+			 * rounds do not recompute them.
+			 * `prune` (which must be copyable) behaves as for `depthFirst`.
+			 **************************************************/
+			template<class E, class Prune = NoPrune>
+			std::shared_ptr<Stream<Visit<E>>> iterativeDeepening(typename LazyTree<E>::TreeT root, Prune prune = Prune(), std::size_t maxDepth = std::numeric_limits<std::size_t>::max()) {
+				return Stream<Visit<E>>::Generate(detail::IterativeDeepeningF<E, Prune>(std::move(root), std::move(prune), maxDepth));
+			}
+		}
+	}
+}
@@ -0,0 +1,345 @@
+#pragma once
+/************************************************************************************
+ *
+ * Author: Thomas Dickerson
+ * Copyright: 2021, Geopipe, Inc.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ************************************************************************************/
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include <functional-cxx/support/hashing.hpp>
+#include <functional-cxx/support/open-hash-table.hpp>
+#include <functional-cxx/support/parking.hpp>
+
+namespace com {
+	namespace geopipe {
+		/**************************************************
+		 * Tools for functional programming
+		 **************************************************/
+		namespace functional {
+			/// Tuning knobs for `memoize` and `concurrentMemoize`.
+			struct MemoOptions {
+				/**************************************************
+				 * If non-zero, at most (approximately, for the concurrent
+				 * variant) this many results are retained, and the least
+				 * recently useful are evicted by the CLOCK algorithm.
+				 **************************************************/
+				std::size_t capacity = 0;
+				/**************************************************
+				 * Recursive calls nested deeper than this are not made
+				 * on the native stack, but deferred to an explicit work
+				 * stack. See `Memoized`.
+				 **************************************************/
+				std::size_t maxNativeDepth = 256;
+				/// Number of independently locked shards for `concurrentMemoize`. Zero picks one from the core count.
+				std::size_t shards = 0;
+			};
+
+			/**************************************************
+			 * Internal implementation details
+			 **************************************************/
+			namespace detail {
+				template<class R>
+				struct MemoEntry {
+					R value;
+					bool referenced; ///< CLOCK's second-chance bit.
+				};
+
+				/**************************************************
+				 * The single-threaded memo table: an `OpenHashMap`,
+				 * optionally bounded by CLOCK eviction, which sweeps
+				 * a hand over the slots clearing reference bits until
+				 * it finds an entry which has not been hit since its
+				 * last sweep.
+				 **************************************************/
+				template<class Key, class R>
+				class MemoTable {
+					OpenHashMap<Key, MemoEntry<R>> map_;
+					std::size_t capacity_;
+					std::size_t hand_;
+
+					void evictOne() {
+						for(;;) {
+							hand_ &= map_.slotCount() - 1;
+							if(map_.occupied(hand_)) {
+								MemoEntry<R>& e = map_.valueAt(hand_);
+								if(!e.referenced) {
+									// Backward-shift may refill this slot, so the hand stays put.
+									map_.eraseAt(hand_);
+									return;
+								}
+								e.referenced = false;
+							}
+							++hand_;
+						}
+					}
+				public:
+					explicit MemoTable(const MemoOptions& options)
+					: capacity_(options.capacity), hand_(0) {
+						if(capacity_) {
+							// Sized up front, so slots never move and the hand stays meaningful.
+							map_.reserve(capacity_);
+						}
+					}
+
+					std::size_t size() const {
+						return map_.size();
+					}
+
+					std::optional<R> find(const Key& key) {
+						if(MemoEntry<R>* e = map_.find(key)) {
+							e->referenced = true;
+							return e->value;
+						}
+						return std::nullopt;
+					}
+
+					void insert(Key && key, const R& value) {
+						if(capacity_ && map_.size() >= capacity_ && !map_.find(key)) {
+							evictOne();
+						}
+						map_.tryEmplace(std::move(key), MemoEntry<R>{value, false});
+					}
+
+					void clear() {
+						map_.clear();
+					}
+				};
+
+				/**************************************************
+				 * The thread-safe memo table: `MemoTable`s sharded by
+				 * the high bits of the key's hash (the low bits pick
+				 * slots within a shard), each behind its own mutex.
+				 * Values are computed outside the lock, so two threads
+				 * may race to compute the same result; the first to
+				 * finish wins.
+				 **************************************************/
+				template<class Key, class R>
+				class ConcurrentMemoTable {
+					struct alignas(kCacheLineSize) Shard {
+						std::mutex mutex;
+						MemoTable<Key, R> table;
+						explicit Shard(const MemoOptions& options) : table(options) {}
+					};
+
+					std::vector<std::unique_ptr<Shard>> shards_;
+
+					Shard& shardFor(const Key& key) {
+						return *shards_[(Hash<Key>()(key) >> 32) % shards_.size()];
+					}
+				public:
+					explicit ConcurrentMemoTable(const MemoOptions& options) {
+						std::size_t n = options.shards ? options.shards : 4 * std::max<std::size_t>(1, std::thread::hardware_concurrency());
+						MemoOptions perShard = options;
+						perShard.capacity = options.capacity ? (options.capacity + n - 1) / n : 0;
+						shards_.reserve(n);
+						for(std::size_t i = 0; i < n; ++i) {
+							shards_.push_back(std::make_unique<Shard>(perShard));
+						}
+					}
+
+					std::size_t size() {
+						std::size_t total = 0;
+						for(auto& s : shards_) {
+							std::lock_guard<std::mutex> lock(s->mutex);
+							total += s->table.size();
+						}
+						return total;
+					}
+
+					std::optional<R> find(const Key& key) {
+						Shard& s = shardFor(key);
+						std::lock_guard<std::mutex> lock(s.mutex);
+						return s.table.find(key);
+					}
+
+					void insert(Key && key, const R& value) {
+						Shard& s = shardFor(key);
+						std::lock_guard<std::mutex> lock(s.mutex);
+						s.table.insert(std::move(key), value);
+					}
+
+					void clear() {
+						for(auto& s : shards_) {
+							std::lock_guard<std::mutex> lock(s->mutex);
+							s->table.clear();
+						}
+					}
+				};
+
+				/// The key and result types of a memoized function of signature `Signature`.
+				template<class Signature> struct MemoTraits;
+
+				template<class R, class ...Args>
+				struct MemoTraits<R(Args...)> {
+					using Key = std::tuple<std::decay_t<Args>...>;
+					using Result = R;
+				};
+
+				template<class Signature>
+				using MemoTableFor = MemoTable<typename MemoTraits<Signature>::Key, typename MemoTraits<Signature>::Result>;
+
+				template<class Signature>
+				using ConcurrentMemoTableFor = ConcurrentMemoTable<typename MemoTraits<Signature>::Key, typename MemoTraits<Signature>::Result>;
+
+				/// Thrown through user code to unwind a call chain that has grown past `MemoOptions::maxNativeDepth`.
+				struct DeferredCall {};
+			}
+
+			template<class Signature, class F, class Table> class Memoized;
+
+			/**************************************************
+			 * A memoized fixed point of `F`: a recursive function
+			 * whose results are cached in an open-addressing table
+			 * keyed by its (decayed) arguments.
+			 *
+			 * `F` is invoked as `f(self, args...)`, where calling
+			 * `self(args...)` makes a memoized recursive call, so
+			 * neither the recursion nor the cache need be hand-rolled.
+			 *
+			 * Recursion is on the native stack up to
+			 * `MemoOptions::maxNativeDepth`. A call nested deeper than
+			 * that pushes its arguments onto an explicit work stack and
+			 * unwinds (by throwing a private exception type) back to the
+			 * outermost call, which then evaluates the deferred call
+			 * first and retries. Every retry finds the results it needs
+			 * memoized (they are pinned for the duration of the outermost
+			 * call, even if bounded eviction would discard them), so the
+			 * total work stays linear, and chains of any depth use
+			 * bounded native stack.
+			 *
+			 * @pre `F` must be pure, and exception-neutral: it must not
+			 * swallow exceptions thrown by calls to `self` (e.g. with
+			 * `catch(...)`), and anything it has done before such a call
+			 * may be repeated.
+			 **************************************************/
+			template<class R, class ...Args, class F, class Table>
+			class Memoized<R(Args...), F, Table> {
+				using Key = typename detail::MemoTraits<R(Args...)>::Key;
+
+				/// State for one outermost call.
+				struct Driver {
+					std::vector<Key> deferred;
+					detail::OpenHashMap<Key, R> pinned;
+				};
+
+				F f_;
+				mutable Table table_;
+				std::size_t maxDepth_;
+			public:
+				/// The handle through which `F` recurses.
+				class Self {
+					friend class Memoized;
+					const Memoized *memo_;
+					Driver *driver_;
+					std::size_t depth_;
+
+					Self(const Memoized *memo, Driver *driver, std::size_t depth)
+					: memo_(memo), driver_(driver), depth_(depth) {}
+				public:
+					R operator()(Args... args) const {
+						return memo_->call(Key(std::forward<Args>(args)...), *driver_, depth_ + 1);
+					}
+				};
+			private:
+				R call(Key && key, Driver& driver, std::size_t depth) const {
+					if(std::optional<R> hit = table_.find(key)) {
+						return std::move(*hit);
+					}
+					if(const R* pinned = driver.pinned.find(key)) {
+						return *pinned;
+					}
+					if(depth > maxDepth_) {
+						driver.deferred.push_back(std::move(key));
+						throw detail::DeferredCall();
+					}
+					Self self(this, &driver, depth);
+					R result = std::apply([&](const auto& ...args) -> R {
+						return f_(self, args...);
+					}, key);
+					table_.insert(std::move(key), result);
+					return result;
+				}
+			public:
+				Memoized(F f, const MemoOptions& options)
+				: f_(std::move(f)), table_(options), maxDepth_(options.maxNativeDepth ? options.maxNativeDepth : 1) {}
+
+				R operator()(Args... args) const {
+					Driver driver;
+					driver.deferred.emplace_back(std::forward<Args>(args)...);
+					for(;;) {
+						Key key = driver.deferred.back();
+						try {
+							R result = call(Key(key), driver, 0);
+							driver.deferred.pop_back();
+							if(driver.deferred.empty()) {
+								return result;
+							}
+							driver.pinned.tryEmplace(std::move(key), std::move(result));
+						} catch(const detail::DeferredCall&) {
+							// A deeper call is now on top of `deferred`; evaluate it first.
+						}
+					}
+				}
+
+				/// Number of results currently cached.
+				std::size_t size() const {
+					return table_.size();
+				}
+
+				void clear() {
+					table_.clear();
+				}
+			};
+
+			/**************************************************
+			 * Memoize the recursive function `f`, of signature `R(Args...)`.
+			 * See `Memoized`. For example:
+			 * ~~~
+			 * auto fib = memoize<std::uint64_t(unsigned)>([](auto& fib, unsigned n) -> std::uint64_t {
+			 *     return n < 2 ? n : fib(n - 1) + fib(n - 2);
+			 * });
+			 * ~~~
+			 * The result is not thread-safe; see `concurrentMemoize`.
+			 **************************************************/
+			template<class Signature, class F>
+			Memoized<Signature, F, detail::MemoTableFor<Signature>> memoize(F f, const MemoOptions& options = MemoOptions()) {
+				return Memoized<Signature, F, detail::MemoTableFor<Signature>>(std::move(f), options);
+			}
+
+			/**************************************************
+			 * As `memoize`, but the result may be called from many
+			 * threads at once, sharing one sharded cache.
+			 * `f` must be safe to invoke concurrently.
+			 **************************************************/
+			template<class Signature, class F>
+			Memoized<Signature, F, detail::ConcurrentMemoTableFor<Signature>> concurrentMemoize(F f, const MemoOptions& options = MemoOptions()) {
+				return Memoized<Signature, F, detail::ConcurrentMemoTableFor<Signature>>(std::move(f), options);
+			}
+		}
+	}
+}
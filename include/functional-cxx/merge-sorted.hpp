@@ -0,0 +1,254 @@
+#pragma once
+/************************************************************************************
+ *
+ * Author: Thomas Dickerson
+ * Copyright: 2021, Geopipe, Inc.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ************************************************************************************/
+
+#include <algorithm>
+#include <cstddef>
+#include <functional>
+#include <iterator>
+#include <memory>
+#include <optional>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include <functional-cxx/stream.hpp>
+
+namespace com {
+	namespace geopipe {
+		/**************************************************
+		 * Tools for functional programming
+		 **************************************************/
+		namespace functional {
+			/**************************************************
+			 * Internal implementation details
+			 **************************************************/
+			namespace detail {
+				/// Position within a plain `Stream`, for use as a `LoserTree` leaf.
+				template<class E>
+				class StreamCursor {
+					std::shared_ptr<Stream<E>> cell_;
+				public:
+					using value_type = E;
+
+					explicit StreamCursor(std::shared_ptr<Stream<E>> cell)
+					: cell_(std::move(cell)) {}
+
+					bool exhausted() const {
+						return !cell_;
+					}
+
+					const E& head() const {
+						return cell_->head();
+					}
+
+					void advance() {
+						cell_ = cell_->tail();
+					}
+				};
+
+				/// Position within a `Stream` of chunks (any sized, indexable range), for use as a `LoserTree` leaf.
+				template<class C>
+				class ChunkCursor {
+					std::shared_ptr<Stream<C>> cell_;
+					std::size_t index_;
+
+					void skipEmpty() {
+						while(cell_ && std::size(cell_->head()) == 0) {
+							cell_ = cell_->tail();
+						}
+					}
+				public:
+					using value_type = std::decay_t<decltype(std::declval<const C&>()[0])>;
+
+					explicit ChunkCursor(std::shared_ptr<Stream<C>> cell)
+					: cell_(std::move(cell)), index_(0) {
+						skipEmpty();
+					}
+
+					bool exhausted() const {
+						return !cell_;
+					}
+
+					const value_type& head() const {
+						return cell_->head()[index_];
+					}
+
+					void advance() {
+						if(++index_ == std::size(cell_->head())) {
+							index_ = 0;
+							cell_ = cell_->tail();
+							skipEmpty();
+						}
+					}
+				};
+
+				/**************************************************
+				 * A tournament tree of losers over `k` sorted inputs.
+				 *
+				 * Leaves occupy the implicit heap positions `k..2k-1`,
+				 * internal node `n` records the loser of the match played
+				 * there, and `tree_[0]` holds the overall winner, so
+				 * replacing the winner costs exactly one comparison per
+				 * level on the path back to the root.
+				 * Exhausted inputs lose every match, and ties are broken
+				 * by input index so the merge is stable.
+				 **************************************************/
+				template<class Cursor, class Compare>
+				class LoserTree {
+					std::vector<Cursor> leaves_;
+					std::vector<std::size_t> tree_;
+					Compare cmp_;
+					bool started_;
+
+					bool beats(std::size_t a, std::size_t b) {
+						if(leaves_[a].exhausted()) {
+							return false;
+						} else if(leaves_[b].exhausted()) {
+							return true;
+						} else if(cmp_(leaves_[a].head(), leaves_[b].head())) {
+							return true;
+						} else if(cmp_(leaves_[b].head(), leaves_[a].head())) {
+							return false;
+						} else {
+							return a < b;
+						}
+					}
+
+					std::size_t build(std::size_t node) {
+						std::size_t k = leaves_.size();
+						if(node >= k) {
+							return node - k;
+						}
+						std::size_t left = build(2 * node);
+						std::size_t right = build(2 * node + 1);
+						if(beats(right, left)) {
+							tree_[node] = left;
+							return right;
+						} else {
+							tree_[node] = right;
+							return left;
+						}
+					}
+
+					void replay(std::size_t leaf) {
+						std::size_t winner = leaf;
+						for(std::size_t node = (leaf + leaves_.size()) / 2; node > 0; node /= 2) {
+							if(beats(tree_[node], winner)) {
+								std::swap(tree_[node], winner);
+							}
+						}
+						tree_[0] = winner;
+					}
+				public:
+					LoserTree(std::vector<Cursor> && leaves, Compare && cmp)
+					: leaves_(std::move(leaves)), tree_(std::max<std::size_t>(leaves_.size(), 1)), cmp_(std::move(cmp)), started_(false) {
+						if(!leaves_.empty()) {
+							tree_[0] = build(1);
+						}
+					}
+
+					/**************************************************
+					 * The current minimum across all inputs, or `nullptr`
+					 * once they are all exhausted.
+					 * Valid until the next call to `LoserTree::next`.
+					 * Only forces the input that supplied the previous minimum.
+					 **************************************************/
+					const typename Cursor::value_type* next() {
+						if(leaves_.empty()) {
+							return nullptr;
+						}
+						if(started_ && !leaves_[tree_[0]].exhausted()) {
+							leaves_[tree_[0]].advance();
+							replay(tree_[0]);
+						}
+						started_ = true;
+						const Cursor& winner = leaves_[tree_[0]];
+						return winner.exhausted() ? nullptr : &winner.head();
+					}
+				};
+			}
+
+			/**************************************************
+			 * Merge individually sorted `Stream`s into a single sorted `Stream`.
+			 *
+			 * Uses a loser tree, so each output element costs
+			 * `ceil(log2(k))` comparisons, and forces exactly one input
+			 * `Stream::tail` (that of the input which supplied the
+			 * previous element). The merge is stable with respect to
+			 * the order of `streams`.
+			 **************************************************/
+			template<class E, class Compare = std::less<E>>
+			std::shared_ptr<Stream<E>> mergeSorted(std::vector<std::shared_ptr<Stream<E>>> streams, Compare cmp = Compare()) {
+				using Cursor = detail::StreamCursor<E>;
+				std::vector<Cursor> leaves;
+				leaves.reserve(streams.size());
+				for(auto &s : streams) {
+					leaves.emplace_back(std::move(s));
+				}
+				auto tree = std::make_unique<detail::LoserTree<Cursor, Compare>>(std::move(leaves), std::move(cmp));
+				return Stream<E>::Generate([tree = std::move(tree)]() -> std::optional<E> {
+					if(const E* e = tree->next()) {
+						return *e;
+					}
+					return std::nullopt;
+				});
+			}
+
+			/**************************************************
+			 * Merge individually sorted, chunked `Stream`s into a single
+			 * sorted `Stream` of chunks of up to `chunkSize` elements.
+			 *
+			 * Within a chunk, advancing an input is just an index
+			 * increment, and one output cell is allocated per
+			 * `chunkSize` elements, so comparisons dominate the cost
+			 * rather than pointer chasing and allocation.
+			 * Empty input chunks are skipped.
+			 **************************************************/
+			template<class C, class Compare = std::less<typename detail::ChunkCursor<C>::value_type>>
+			std::shared_ptr<Stream<std::vector<typename detail::ChunkCursor<C>::value_type>>> mergeSortedChunks(std::vector<std::shared_ptr<Stream<C>>> streams, Compare cmp = Compare(), std::size_t chunkSize = 1024) {
+				using Cursor = detail::ChunkCursor<C>;
+				using E = typename Cursor::value_type;
+				std::vector<Cursor> leaves;
+				leaves.reserve(streams.size());
+				for(auto &s : streams) {
+					leaves.emplace_back(std::move(s));
+				}
+				auto tree = std::make_unique<detail::LoserTree<Cursor, Compare>>(std::move(leaves), std::move(cmp));
+				chunkSize = chunkSize ? chunkSize : 1;
+				return Stream<std::vector<E>>::Generate([tree = std::move(tree), chunkSize]() -> std::optional<std::vector<E>> {
+					std::vector<E> chunk;
+					chunk.reserve(chunkSize);
+					while(chunk.size() < chunkSize) {
+						const E* e = tree->next();
+						if(!e) {
+							break;
+						}
+						chunk.push_back(*e);
+					}
+					if(chunk.empty()) {
+						return std::nullopt;
+					}
+					return chunk;
+				});
+			}
+		}
+	}
+}
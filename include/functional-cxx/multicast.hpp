@@ -0,0 +1,277 @@
+#pragma once
+/************************************************************************************
+ *
+ * Author: Thomas Dickerson
+ * Copyright: 2021, Geopipe, Inc.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ************************************************************************************/
+
+#include <algorithm>
+#include <condition_variable>
+#include <cstddef>
+#include <limits>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <utility>
+
+#include <functional-cxx/stream.hpp>
+
+namespace com {
+	namespace geopipe {
+		/**************************************************
+		 * Tools for functional programming
+		 **************************************************/
+		namespace functional {
+			/**************************************************
+			 * What a `Multicast` should do when its fastest
+			 * `Multicast::Cursor` gets too far ahead of its slowest.
+			 **************************************************/
+			enum class LagPolicy {
+				Unbounded, ///< No flow control: every cell between the slowest and fastest cursors is retained.
+				Block, ///< Backpressure: a cursor may not pull more than `bound` elements ahead of the slowest cursor.
+				DropOldest ///< Lagging cursors are skipped forward so that they are never more than `bound` elements behind.
+			};
+
+			/// A snapshot of the positions of all the cursors attached to a `Multicast`.
+			struct LagStats {
+				std::size_t cursors; ///< Number of live cursors.
+				std::size_t frontier; ///< Number of elements pulled by the fastest cursor.
+				std::size_t slowest; ///< Number of elements pulled by the slowest cursor.
+				std::size_t maxLag; ///< `frontier - slowest`, approximately the number of cells kept alive by the hub.
+				std::size_t dropped; ///< Total number of elements skipped under `LagPolicy::DropOldest`.
+			};
+
+			/**************************************************
+			 * A fan-out hub that hands out independent cursors
+			 * over a single memoized `Stream`.
+			 *
+			 * Each cursor only pins the cell it most recently
+			 * returned, so the cells retained by the hub are exactly
+			 * those between the slowest and the fastest cursor.
+			 * The `LagPolicy` decides what happens when that window
+			 * grows beyond `bound` elements.
+			 *
+			 * All forcing of the shared `Stream` happens under the
+			 * hub's lock, so cursors may be driven from different threads
+			 * even though `Stream::tail` itself is not thread-safe.
+			 *
+			 * @warning With `LagPolicy::Block`, a leading cursor waits for
+			 * the slowest one to catch up, so driving two cursors from the
+			 * same thread can deadlock.
+			 **************************************************/
+			template<class E>
+			class Multicast {
+			public:
+				using StreamT = std::shared_ptr<Stream<E>>;
+			private:
+				/**************************************************
+				 * Position of a single cursor.
+				 * If `pending` is set, `cell` has not been returned yet,
+				 * otherwise it is the cell most recently returned.
+				 **************************************************/
+				struct Slot {
+					StreamT cell;
+					bool pending;
+					std::size_t index;
+					std::size_t dropped;
+
+					/// Advance by one cell, forcing the tail if necessary.
+					const StreamT& step() {
+						if(pending) {
+							pending = false;
+						} else if(cell) {
+							cell = cell->tail();
+						}
+						if(cell) {
+							++index;
+						}
+						return cell;
+					}
+				};
+
+				struct State {
+					std::mutex mutex;
+					std::condition_variable progressed;
+					std::list<Slot> slots;
+					Slot parked; ///< Where the next cursor resumes if no cursors are attached.
+					std::size_t frontier;
+					std::size_t dropped;
+					const LagPolicy policy;
+					const std::size_t bound;
+
+					State(StreamT source, LagPolicy p, std::size_t b)
+					: parked{std::move(source), true, 0, 0}, frontier(0), dropped(0), policy(p), bound(std::max<std::size_t>(b, 1)) {}
+
+					/// @pre `mutex` is held.
+					std::size_t slowest() const {
+						std::size_t result = frontier;
+						for(const Slot& s : slots) {
+							result = std::min(result, s.index);
+						}
+						return result;
+					}
+
+					/// Skip lagging cursors forward so none is more than `bound` behind the `frontier`.
+					/// @pre `mutex` is held.
+					void dropLagging() {
+						for(Slot& s : slots) {
+							while(s.cell && frontier - s.index > bound) {
+								s.step();
+								++s.dropped;
+								++dropped;
+							}
+						}
+					}
+				};
+
+				std::shared_ptr<State> state_;
+			public:
+				/**************************************************
+				 * A single consumer's view of the `Multicast`.
+				 * Move-only; detaches from the hub on destruction,
+				 * releasing whatever cells only it was keeping alive.
+				 **************************************************/
+				class Cursor {
+					friend class Multicast<E>;
+					std::shared_ptr<State> state_;
+					typename std::list<Slot>::iterator slot_;
+
+					Cursor(std::shared_ptr<State> state, typename std::list<Slot>::iterator slot)
+					: state_(std::move(state)), slot_(slot) {}
+				public:
+					Cursor(const Cursor&) = delete;
+					Cursor& operator=(const Cursor&) = delete;
+					Cursor(Cursor && other) noexcept
+					: state_(std::move(other.state_)), slot_(other.slot_) {}
+
+					Cursor& operator=(Cursor && other) noexcept {
+						if(this != &other) {
+							detach();
+							state_ = std::move(other.state_);
+							slot_ = other.slot_;
+						}
+						return *this;
+					}
+
+					~Cursor() {
+						detach();
+					}
+
+					/**************************************************
+					 * Obtain the next cell of the shared `Stream`, or
+					 * `Stream::Nil()` once it is exhausted.
+					 *
+					 * The returned cell's `Stream::tail` must not be
+					 * forced outside of the hub if other cursors are being
+					 * driven concurrently.
+					 **************************************************/
+					StreamT pull() {
+						std::unique_lock<std::mutex> lock(state_->mutex);
+						Slot& s = *slot_;
+						if(state_->policy == LagPolicy::Block) {
+							state_->progressed.wait(lock, [&](){
+								return !s.cell || s.index - state_->slowest() < state_->bound;
+							});
+						}
+						StreamT result = s.step();
+						if(s.index > state_->frontier) {
+							state_->frontier = s.index;
+							if(state_->policy == LagPolicy::DropOldest) {
+								state_->dropLagging();
+							}
+						}
+						if(state_->policy == LagPolicy::Block) {
+							lock.unlock();
+							state_->progressed.notify_all();
+						}
+						return result;
+					}
+
+					/// Number of elements this cursor has pulled or had dropped.
+					std::size_t index() const {
+						std::lock_guard<std::mutex> lock(state_->mutex);
+						return slot_->index;
+					}
+
+					/// How far this cursor is behind the fastest cursor.
+					std::size_t lag() const {
+						std::lock_guard<std::mutex> lock(state_->mutex);
+						return state_->frontier - slot_->index;
+					}
+
+					/// Number of elements this cursor missed under `LagPolicy::DropOldest`.
+					std::size_t dropped() const {
+						std::lock_guard<std::mutex> lock(state_->mutex);
+						return slot_->dropped;
+					}
+
+				private:
+					void detach() {
+						if(state_) {
+							{
+								std::lock_guard<std::mutex> lock(state_->mutex);
+								if(state_->slots.size() == 1) {
+									state_->parked = std::move(*slot_);
+								}
+								state_->slots.erase(slot_);
+							}
+							state_->progressed.notify_all();
+							state_ = nullptr;
+						}
+					}
+				};
+
+				/**************************************************
+				 * Wrap `source` for fan-out.
+				 * The hub itself only retains `source` until the first
+				 * `Multicast::subscribe`.
+				 **************************************************/
+				explicit Multicast(StreamT source, LagPolicy policy = LagPolicy::Unbounded, std::size_t bound = std::numeric_limits<std::size_t>::max())
+				: state_(std::make_shared<State>(std::move(source), policy, bound)) {}
+
+				/**************************************************
+				 * Attach a new cursor.
+				 * It starts at the position of the slowest attached cursor
+				 * (i.e. the oldest element still retained), or where the
+				 * last cursor left off if none are attached.
+				 **************************************************/
+				Cursor subscribe() {
+					std::lock_guard<std::mutex> lock(state_->mutex);
+					Slot start;
+					if(state_->slots.empty()) {
+						start = std::move(state_->parked);
+						state_->parked = Slot{nullptr, false, start.index, 0};
+					} else {
+						start = *std::min_element(state_->slots.begin(), state_->slots.end(), [](const Slot& a, const Slot& b){
+							return a.index < b.index;
+						});
+					}
+					start.dropped = 0;
+					auto slot = state_->slots.insert(state_->slots.end(), std::move(start));
+					return Cursor(state_, slot);
+				}
+
+				/// Observe the spread of the attached cursors.
+				LagStats stats() const {
+					std::lock_guard<std::mutex> lock(state_->mutex);
+					std::size_t slowest = state_->slowest();
+					return LagStats{state_->slots.size(), state_->frontier, slowest, state_->frontier - slowest, state_->dropped};
+				}
+			};
+		}
+	}
+}
@@ -0,0 +1,294 @@
+#pragma once
+/************************************************************************************
+ *
+ * Author: Thomas Dickerson
+ * Copyright: 2021, Geopipe, Inc.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ************************************************************************************/
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include <functional-cxx/lazy-tree.hpp>
+#include <functional-cxx/support/hashing.hpp>
+#include <functional-cxx/support/parking.hpp>
+
+namespace com {
+	namespace geopipe {
+		/**************************************************
+		 * Tools for functional programming
+		 **************************************************/
+		namespace functional {
+			/**************************************************
+			 * The incumbent for a branch-and-bound search, shared
+			 * between the workers of a `parallelDepthFirst`.
+			 *
+			 * `improve` only ever moves the bound in the direction
+			 * of `Compare` (by default, downwards, for minimization),
+			 * so concurrent improvements never lose the best one.
+			 * `T` must be usable with `std::atomic`.
+			 **************************************************/
+			template<class T, class Compare = std::less<T>>
+			class SharedBound {
+				alignas(detail::kCacheLineSize) std::atomic<T> value_;
+				Compare compare_;
+			public:
+				explicit SharedBound(T initial, Compare compare = Compare())
+				: value_(initial), compare_(std::move(compare)) {}
+
+				SharedBound(const SharedBound&) = delete;
+				SharedBound& operator=(const SharedBound&) = delete;
+
+				T get() const {
+					return value_.load(std::memory_order_acquire);
+				}
+
+				/// Replace the bound with `candidate` if it is better. Returns whether it was.
+				bool improve(T candidate) {
+					T current = value_.load(std::memory_order_relaxed);
+					while(compare_(candidate, current)) {
+						if(value_.compare_exchange_weak(current, candidate, std::memory_order_acq_rel, std::memory_order_relaxed)) {
+							return true;
+						}
+					}
+					return false;
+				}
+			};
+
+			/// Tuning knobs for `parallelDepthFirst`.
+			struct ParallelSearchOptions {
+				std::size_t threads = 0; ///< Number of workers, including the caller. Zero means `std::thread::hardware_concurrency()`.
+			};
+
+			/**************************************************
+			 * Internal implementation details
+			 **************************************************/
+			namespace detail {
+				/**************************************************
+				 * Shared state for `parallelDepthFirst`.
+				 *
+				 * Each worker owns a deque of unexpanded nodes. It pushes
+				 * and pops at the back, so on its own it is a depth-first
+				 * search, while idle workers steal from the front, where
+				 * the shallowest (and so typically largest) subtrees are.
+				 * A node is only ever in one deque, so its children are
+				 * forced by exactly one thread: whichever one claimed it.
+				 * Workers which find nothing to steal park on `idle_`
+				 * until more nodes are queued, or the search ends.
+				 **************************************************/
+				template<class E, class Visitor, class Prune>
+				class WorkStealingSearch {
+					struct alignas(kCacheLineSize) Worker {
+						std::mutex mutex;
+						std::deque<Visit<E>> tasks;
+					};
+
+					std::vector<Worker> workers_;
+					alignas(kCacheLineSize) std::atomic<std::size_t> pending_; ///< Nodes pushed but not yet fully processed.
+					std::atomic<std::size_t> queued_; ///< Nodes sitting in some deque.
+					std::atomic<std::size_t> visited_;
+					std::atomic<bool> stop_;
+					std::mutex errorMutex_;
+					std::exception_ptr error_;
+					Visitor& visitor_;
+					Prune& prune_;
+					Parker idle_;
+
+					void halt() {
+						stop_.store(true, std::memory_order_relaxed);
+						idle_.notify();
+					}
+
+					std::optional<Visit<E>> popLocal(std::size_t self) {
+						Worker& w = workers_[self];
+						std::lock_guard<std::mutex> lock(w.mutex);
+						if(w.tasks.empty()) {
+							return std::nullopt;
+						}
+						Visit<E> v = std::move(w.tasks.back());
+						w.tasks.pop_back();
+						queued_.fetch_sub(1, std::memory_order_relaxed);
+						return v;
+					}
+
+					std::optional<Visit<E>> steal(std::size_t self, std::uint64_t& rng) {
+						std::size_t n = workers_.size();
+						rng ^= rng << 13;
+						rng ^= rng >> 7;
+						rng ^= rng << 17;
+						std::size_t start = std::size_t(rng % n);
+						for(std::size_t k = 0; k < n; ++k) {
+							std::size_t victim = (start + k) % n;
+							if(victim == self) {
+								continue;
+							}
+							Worker& w = workers_[victim];
+							std::unique_lock<std::mutex> lock(w.mutex, std::try_to_lock);
+							if(lock && !w.tasks.empty()) {
+								Visit<E> v = std::move(w.tasks.front());
+								w.tasks.pop_front();
+								queued_.fetch_sub(1, std::memory_order_relaxed);
+								return v;
+							}
+						}
+						return std::nullopt;
+					}
+
+					void process(std::size_t self, const Visit<E>& v, std::vector<Visit<E>>& scratch) {
+						visited_.fetch_add(1, std::memory_order_relaxed);
+						if constexpr (std::is_void_v<std::invoke_result_t<Visitor&, const Visit<E>&>>) {
+							visitor_(v);
+						} else if(!visitor_(v)) {
+							halt();
+							return;
+						}
+						if(prune_(v.node->head(), v.depth)) {
+							return;
+						}
+						for(auto cell = v.node->children(); cell; cell = cell->tail()) {
+							scratch.push_back(Visit<E>{cell->head(), v.depth + 1});
+						}
+						if(scratch.empty()) {
+							return;
+						}
+						pending_.fetch_add(scratch.size(), std::memory_order_relaxed);
+						{
+							Worker& w = workers_[self];
+							std::lock_guard<std::mutex> lock(w.mutex);
+							// Reversed, so that the leftmost child is popped first.
+							for(auto it = scratch.rbegin(); it != scratch.rend(); ++it) {
+								w.tasks.push_back(std::move(*it));
+							}
+							queued_.fetch_add(scratch.size(), std::memory_order_relaxed);
+						}
+						scratch.clear();
+						idle_.notify();
+					}
+				public:
+					WorkStealingSearch(std::size_t threads, Visitor& visitor, Prune& prune)
+					: workers_(threads), pending_(0), queued_(0), visited_(0), stop_(false), visitor_(visitor), prune_(prune) {}
+
+					void seed(typename LazyTree<E>::TreeT root) {
+						if(root) {
+							pending_.store(1, std::memory_order_relaxed);
+							queued_.store(1, std::memory_order_relaxed);
+							workers_[0].tasks.push_back(Visit<E>{std::move(root), 0});
+						}
+					}
+
+					void run(std::size_t self) {
+						std::uint64_t rng = mix64(self + 1);
+						std::vector<Visit<E>> scratch;
+						while(!stop_.load(std::memory_order_relaxed)) {
+							std::optional<Visit<E>> task = popLocal(self);
+							if(!task) {
+								task = steal(self, rng);
+							}
+							if(!task) {
+								if(pending_.load(std::memory_order_acquire) == 0) {
+									return;
+								}
+								idle_.wait([this](){
+									return queued_.load() || !pending_.load() || stop_.load();
+								}, 64);
+								continue;
+							}
+							try {
+								process(self, *task, scratch);
+							} catch(...) {
+								std::lock_guard<std::mutex> lock(errorMutex_);
+								if(!error_) {
+									error_ = std::current_exception();
+								}
+								scratch.clear();
+								halt();
+							}
+							task.reset();
+							if(pending_.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+								idle_.notify();
+							}
+						}
+					}
+
+					std::size_t finish() {
+						if(error_) {
+							std::rethrow_exception(error_);
+						}
+						return visited_.load(std::memory_order_relaxed);
+					}
+				};
+			}
+
+			/**************************************************
+			 * Visit every node of `root` using a pool of work-stealing
+			 * threads (the caller is one of them), and return how many
+			 * nodes were visited.
+			 *
+			 * Each worker runs a depth-first search over its own
+			 * subtrees, so `visitor` sees every node before its
+			 * descendants, but there is no global order.
+			 *
+			 * @arg visitor is invoked as `visitor(const Visit<E>&)`.
+			 * If it returns something convertible to `bool`, returning
+			 * `false` stops the whole search as soon as possible.
+			 * @arg prune is invoked as `prune(head, depth)` after a node
+			 * is visited and before its children are forced, and returning
+			 * `true` skips its subtree. For branch-and-bound, have `visitor`
+			 * `improve` a `SharedBound`, and `prune` compare against it.
+			 *
+			 * Both are shared by all workers, and so are invoked concurrently.
+			 * The children of each node are forced by whichever worker
+			 * claims it, so they need not be thread-safe with respect to
+			 * each other, but they must not touch unsynchronized shared state.
+			 * The first exception thrown by either is rethrown here, after
+			 * every worker has stopped.
+			 *
+			 * @warning Nodes forced here are memoized as usual, so the tree
+			 * must not be concurrently traversed by anybody else.
+			 **************************************************/
+			template<class E, class Visitor, class Prune = NoPrune>
+			std::size_t parallelDepthFirst(typename LazyTree<E>::TreeT root, Visitor visitor, Prune prune = Prune(), ParallelSearchOptions options = ParallelSearchOptions()) {
+				std::size_t threads = options.threads ? options.threads : std::max<std::size_t>(1, std::thread::hardware_concurrency());
+				detail::WorkStealingSearch<E, Visitor, Prune> search(threads, visitor, prune);
+				search.seed(std::move(root));
+				std::vector<std::thread> pool;
+				pool.reserve(threads - 1);
+				for(std::size_t i = 1; i < threads; ++i) {
+					pool.emplace_back([&search, i](){
+						search.run(i);
+					});
+				}
+				search.run(0);
+				for(auto& t : pool) {
+					t.join();
+				}
+				return search.finish();
+			}
+		}
+	}
+}
@@ -0,0 +1,167 @@
+#pragma once
+/************************************************************************************
+ *
+ * Author: Thomas Dickerson
+ * Copyright: 2021, Geopipe, Inc.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ************************************************************************************/
+
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include <functional-cxx/lazy-wrapper.hpp>
+#include <functional-cxx/stream.hpp>
+
+namespace com {
+	namespace geopipe {
+		/**************************************************
+		 * Tools for functional programming
+		 **************************************************/
+		namespace functional {
+			/**************************************************
+			 * Internal implementation details
+			 **************************************************/
+			namespace detail {
+				/**************************************************
+				 * State shared by all the shards of a partitioned `Stream`.
+				 * The source is only ever forced under `mutex`, a batch
+				 * at a time, by whichever shard runs dry first.
+				 **************************************************/
+				template<class E, class Route>
+				struct PartitionState {
+					using StreamT = std::shared_ptr<Stream<E>>;
+
+					std::mutex mutex;
+					StreamT cursor; ///< If `pending`, the next cell to distribute, otherwise the last cell distributed.
+					bool pending;
+					std::vector<std::vector<E>> queues;
+					Route route;
+					const std::size_t batch;
+
+					PartitionState(StreamT source, std::size_t n, Route && r, std::size_t b)
+					: cursor(std::move(source)), pending(true), queues(n), route(std::move(r)), batch(b ? b : 1) {}
+
+					/// @pre `mutex` is held.
+					bool distribute() {
+						for(std::size_t i = 0; i < batch; ++i) {
+							if(pending) {
+								pending = false;
+							} else if(cursor) {
+								cursor = cursor->tail();
+							}
+							if(!cursor) {
+								return i != 0;
+							}
+							const E& e = cursor->head();
+							queues[route(e) % queues.size()].push_back(e);
+						}
+						return true;
+					}
+
+					/// Swap the pending elements for shard `k` into `out`, forcing the source as needed.
+					bool refill(std::size_t k, std::vector<E> &out) {
+						out.clear();
+						std::lock_guard<std::mutex> lock(mutex);
+						while(queues[k].empty() && distribute()) {}
+						std::swap(out, queues[k]);
+						return !out.empty();
+					}
+				};
+
+				/// Thunk producing the `Stream` for one shard of a partitioned `Stream`.
+				template<class E, class Route>
+				class PartitionShardF {
+					std::shared_ptr<PartitionState<E, Route>> state_;
+					std::size_t shard_;
+				public:
+					PartitionShardF(std::shared_ptr<PartitionState<E, Route>> state, std::size_t shard)
+					: state_(std::move(state)), shard_(shard) {}
+
+					std::shared_ptr<Stream<E>> operator()() {
+						return Stream<E>::Generate([state = std::move(state_), shard = shard_, buffer = std::vector<E>(), next = std::size_t(0)]() mutable -> std::optional<E> {
+							if(next == buffer.size()) {
+								next = 0;
+								if(!state->refill(shard, buffer)) {
+									return std::nullopt;
+								}
+							}
+							return std::move(buffer[next++]);
+						});
+					}
+				};
+
+				template<class E, class Route>
+				std::vector<lazy<PartitionShardF<E, Route>>> makeShards(std::shared_ptr<Stream<E>> source, std::size_t n, Route && route, std::size_t batch) {
+					if(n == 0) {
+						throw std::invalid_argument("Cannot partition a Stream into 0 shards");
+					}
+					auto state = std::make_shared<PartitionState<E, Route>>(std::move(source), n, std::move(route), batch);
+					std::vector<lazy<PartitionShardF<E, Route>>> shards;
+					shards.reserve(n);
+					for(std::size_t k = 0; k < n; ++k) {
+						shards.push_back(lazy<PartitionShardF<E, Route>>{PartitionShardF<E, Route>(state, k)});
+					}
+					return shards;
+				}
+			}
+
+			/**************************************************
+			 * Split `source` into `n` shards by hashing `keyFn(e)`,
+			 * for data-parallel consumption.
+			 *
+			 * Each shard is returned as a `lazy` thunk, which should be
+			 * forced (by moving it into a `std::shared_ptr<Stream<E>>`)
+			 * on the thread that will consume it, since obtaining a shard's
+			 * head may require forcing an arbitrary amount of the source.
+			 *
+			 * The source is forced under a single lock, `batch` elements
+			 * at a time, by whichever consumer runs out of work first,
+			 * and each consumer then takes its whole backlog at once,
+			 * so no consumer touches the shared source per element.
+			 *
+			 * @warning A shard which is never consumed accumulates
+			 * every element routed to it.
+			 **************************************************/
+			template<class E, class KeyFn>
+			auto partition(std::shared_ptr<Stream<E>> source, std::size_t n, KeyFn && keyFn, std::size_t batch = 256) {
+				auto route = [keyFn = std::forward<KeyFn>(keyFn)](const E& e) mutable {
+					using KeyT = std::decay_t<std::invoke_result_t<KeyFn&, const E&>>;
+					return std::hash<KeyT>()(keyFn(e));
+				};
+				return detail::makeShards(std::move(source), n, std::move(route), batch);
+			}
+
+			/**************************************************
+			 * Split `source` into `n` shards round-robin.
+			 * See `partition` for how the shards should be consumed.
+			 **************************************************/
+			template<class E>
+			auto partitionRoundRobin(std::shared_ptr<Stream<E>> source, std::size_t n, std::size_t batch = 256) {
+				auto route = [next = std::size_t(0)](const E&) mutable {
+					return next++;
+				};
+				return detail::makeShards(std::move(source), n, std::move(route), batch);
+			}
+		}
+	}
+}
@@ -0,0 +1,176 @@
+#pragma once
+/************************************************************************************
+ *
+ * Author: Thomas Dickerson
+ * Copyright: 2021, Geopipe, Inc.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ************************************************************************************/
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <limits>
+#include <memory>
+#include <random>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+#include <functional-cxx/stream.hpp>
+
+namespace com {
+	namespace geopipe {
+		/**************************************************
+		 * Tools for functional programming
+		 **************************************************/
+		namespace functional {
+			/**************************************************
+			 * Internal implementation details
+			 **************************************************/
+			namespace detail {
+				/// A uniform variate in `(0, 1)`: never zero, so its logarithm is finite.
+				template<class URBG>
+				double openUniform(URBG& rng) {
+					std::uniform_real_distribution<double> uniform(std::numeric_limits<double>::min(), 1.0);
+					return uniform(rng);
+				}
+			}
+
+			/**************************************************
+			 * A uniform random sample of `k` elements of `source`
+			 * (or all of them, if there are fewer), without replacement,
+			 * in no particular order.
+			 *
+			 * Uses Li's "Algorithm L": rather than drawing a random
+			 * number per element, it draws the geometrically distributed
+			 * number of elements to skip before the next replacement,
+			 * and `drop`s them. So after the reservoir fills, only
+			 * O(k log(n / k)) random numbers are drawn and elements copied.
+			 *
+			 * `source` is taken by rvalue, and each cell is released
+			 * once passed, so this runs in O(k) memory when the caller
+			 * holds no other reference to the `Stream`.
+			 * @warning An unbounded `Stream` will be consumed forever.
+			 **************************************************/
+			template<class E, class URBG>
+			std::vector<E> reservoirSample(std::shared_ptr<Stream<E>> && source, std::size_t k, URBG && rng) {
+				std::vector<E> reservoir;
+				if(!k) {
+					return reservoir;
+				}
+				reservoir.reserve(k);
+				std::shared_ptr<Stream<E>> cell(std::move(source));
+				for(; cell && reservoir.size() < k; cell = drop(std::move(cell), 1)) {
+					reservoir.push_back(cell->head());
+				}
+				std::uniform_int_distribution<std::size_t> slot(0, k - 1);
+				double w = std::exp(std::log(detail::openUniform(rng)) / double(k));
+				while(cell) {
+					double skip = std::floor(std::log(detail::openUniform(rng)) / std::log1p(-w));
+					if(!(skip < double(std::numeric_limits<std::size_t>::max()))) {
+						// Vanishingly unlikely to replace anything ever again.
+						skip = double(std::numeric_limits<std::size_t>::max());
+					}
+					cell = drop(std::move(cell), std::size_t(skip));
+					if(!cell) {
+						break;
+					}
+					reservoir[slot(rng)] = cell->head();
+					cell = drop(std::move(cell), 1);
+					w *= std::exp(std::log(detail::openUniform(rng)) / double(k));
+				}
+				return reservoir;
+			}
+
+			/**************************************************
+			 * A weighted random sample of `k` elements of `source`
+			 * (or all of those with positive weight, if there are
+			 * fewer), without replacement, in no particular order:
+			 * each element is drawn with probability proportional
+			 * to `weight(e)`, among those not yet drawn.
+			 *
+			 * Uses Efraimidis and Spirakis' "A-ExpJ": each element
+			 * in the reservoir holds the key `u^(1 / weight)`, and,
+			 * rather than drawing a key per element, we draw how much
+			 * weight to skip before the next element which would
+			 * displace the least key. So after the reservoir fills,
+			 * only O(k log(n / k)) random numbers are drawn.
+			 * Keys are kept as logarithms, so tiny weights do not
+			 * underflow them.
+			 *
+			 * Elements with zero weight are never sampled.
+			 * Throws `std::invalid_argument` on a negative weight.
+			 * Memory and consumption are as for `reservoirSample`.
+			 **************************************************/
+			template<class E, class Weight, class URBG>
+			std::vector<E> weightedSample(std::shared_ptr<Stream<E>> && source, std::size_t k, Weight && weight, URBG && rng) {
+				struct Entry {
+					double logKey;
+					E element;
+
+					bool operator<(const Entry& other) const {
+						// Inverted, so that `std::push_heap` keeps the least key on top.
+						return logKey > other.logKey;
+					}
+				};
+				auto weigh = [&](const E& e){
+					double w = double(weight(e));
+					if(w < 0) {
+						throw std::invalid_argument("weightedSample: weights must be non-negative");
+					}
+					return w;
+				};
+
+				std::vector<Entry> reservoir;
+				std::vector<E> sample;
+				if(!k) {
+					return sample;
+				}
+				reservoir.reserve(k);
+				std::shared_ptr<Stream<E>> cell(std::move(source));
+				for(; cell && reservoir.size() < k; cell = drop(std::move(cell), 1)) {
+					double w = weigh(cell->head());
+					if(w > 0) {
+						reservoir.push_back(Entry{std::log(detail::openUniform(rng)) / w, cell->head()});
+						std::push_heap(reservoir.begin(), reservoir.end());
+					}
+				}
+				// The weight still to pass before the next replacement: `log(r) / log(least key)`.
+				double remaining = cell ? std::log(detail::openUniform(rng)) / reservoir.front().logKey : 0;
+				for(; cell; cell = drop(std::move(cell), 1)) {
+					double w = weigh(cell->head());
+					remaining -= w;
+					if(remaining > 0) {
+						continue;
+					}
+					// Draw this element's key conditioned on displacing the least: `r^(1 / w)` for `r` uniform in `(least^w, 1)`.
+					double t = std::exp(reservoir.front().logKey * w);
+					std::uniform_real_distribution<double> above(t, 1.0);
+					double key = std::max(above(rng), std::numeric_limits<double>::min());
+					std::pop_heap(reservoir.begin(), reservoir.end());
+					reservoir.back() = Entry{std::log(key) / w, cell->head()};
+					std::push_heap(reservoir.begin(), reservoir.end());
+					remaining = std::log(detail::openUniform(rng)) / reservoir.front().logKey;
+				}
+				sample.reserve(reservoir.size());
+				for(auto& entry : reservoir) {
+					sample.push_back(std::move(entry.element));
+				}
+				return sample;
+			}
+		}
+	}
+}
@@ -0,0 +1,591 @@
+#pragma once
+/************************************************************************************
+ *
+ * Author: Thomas Dickerson
+ * Copyright: 2021, Geopipe, Inc.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ************************************************************************************/
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <limits>
+#include <memory>
+#include <optional>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+#include <functional-cxx/stream.hpp>
+#include <functional-cxx/support/generators.hpp>
+#include <functional-cxx/support/hashing.hpp>
+
+namespace com {
+	namespace geopipe {
+		/**************************************************
+		 * Tools for functional programming
+		 **************************************************/
+		namespace functional {
+			/**************************************************
+			 * Internal implementation details
+			 **************************************************/
+			namespace detail {
+				/// Elements hashed at a time by the `addBatch` paths, so the hashing loop has no dependencies to stall on.
+				constexpr std::size_t kSketchBlock = 64;
+
+				constexpr double kPi = 3.14159265358979323846;
+
+				/// Hash `[first, last)` one block at a time, passing each block of hashes to `f`.
+				template<class H, class It, class F>
+				void forEachHashBlock(const H& hash, It first, It last, F && f) {
+					std::uint64_t hashes[kSketchBlock];
+					while(first != last) {
+						std::size_t n = 0;
+						for(; n < kSketchBlock && first != last; ++n, ++first) {
+							hashes[n] = hash(*first);
+						}
+						f(static_cast<const std::uint64_t*>(hashes), n);
+					}
+				}
+			}
+
+			/**************************************************
+			 * A HyperLogLog sketch, estimating the number of
+			 * distinct elements added in `2^precision` bytes,
+			 * with a relative standard error of about
+			 * `1.04 / sqrt(2^precision)` (0.8% at the default 14).
+			 *
+			 * Each element's hash picks a register with its top
+			 * `precision` bits, which keeps the longest run of
+			 * leading zeros seen in the remaining bits. Merging
+			 * takes the register-wise maximum, so per-shard sketches
+			 * of the same precision combine exactly as if one sketch
+			 * had seen all of their elements.
+			 **************************************************/
+			template<class E, class H = detail::Hash<E>>
+			class HyperLogLog {
+				unsigned precision_;
+				std::vector<std::uint8_t> registers_;
+				H hash_;
+
+				void update(std::uint64_t h) {
+					std::size_t index = std::size_t(h >> (64 - precision_));
+					// The guard bit bounds the rank when the remaining bits are all zero.
+					std::uint64_t rest = (h << precision_) | (std::uint64_t(1) << (precision_ - 1));
+					std::uint8_t rank = std::uint8_t(detail::countLeadingZeros64(rest) + 1);
+					registers_[index] = std::max(registers_[index], rank);
+				}
+			public:
+				explicit HyperLogLog(unsigned precision = 14, H hash = H())
+				: precision_(precision), hash_(std::move(hash)) {
+					if(precision < 4 || precision > 18) {
+						throw std::invalid_argument("HyperLogLog: precision must be between 4 and 18");
+					}
+					registers_.assign(std::size_t(1) << precision, 0);
+				}
+
+				unsigned precision() const {
+					return precision_;
+				}
+
+				void add(const E& e) {
+					update(hash_(e));
+				}
+
+				/// Add every element of `[first, last)`, hashing them a block at a time.
+				template<class It>
+				void addBatch(It first, It last) {
+					detail::forEachHashBlock(hash_, first, last, [&](const std::uint64_t* hashes, std::size_t n){
+						for(std::size_t i = 0; i < n; ++i) {
+							update(hashes[i]);
+						}
+					});
+				}
+
+				/// Fold `other`'s elements into this sketch. Throws `std::invalid_argument` if the precisions differ.
+				void merge(const HyperLogLog& other) {
+					if(other.precision_ != precision_) {
+						throw std::invalid_argument("HyperLogLog::merge: precisions differ");
+					}
+					for(std::size_t i = 0; i < registers_.size(); ++i) {
+						registers_[i] = std::max(registers_[i], other.registers_[i]);
+					}
+				}
+
+				/// The estimated number of distinct elements added.
+				double estimate() const {
+					double m = double(registers_.size());
+					double alpha = m >= 128 ? 0.7213 / (1 + 1.079 / m) : m >= 64 ? 0.709 : m >= 32 ? 0.697 : 0.673;
+					double sum = 0;
+					std::size_t zeros = 0;
+					for(std::uint8_t r : registers_) {
+						sum += std::ldexp(1.0, -int(r));
+						zeros += !r;
+					}
+					double raw = alpha * m * m / sum;
+					if(raw <= 2.5 * m && zeros) {
+						// Linear counting is more accurate while many registers are empty.
+						return m * std::log(m / double(zeros));
+					}
+					return raw;
+				}
+			};
+
+			/**************************************************
+			 * A Count-Min sketch, estimating how many times each
+			 * element was added, in `width * depth` counters.
+			 *
+			 * Estimates never undercount; with `width = e / epsilon`
+			 * and `depth = ln(1 / delta)` (see `CountMinSketch::withError`),
+			 * they overcount by at most `epsilon * total()` with
+			 * probability `1 - delta`. Each row's column is derived
+			 * from a single hash of the element by double hashing.
+			 * Merging adds counters, so sketches of the same shape
+			 * combine exactly.
+			 **************************************************/
+			template<class E, class H = detail::Hash<E>>
+			class CountMinSketch {
+				std::size_t width_;
+				std::size_t depth_;
+				std::vector<std::uint64_t> counters_; ///< Row-major.
+				std::uint64_t total_;
+				H hash_;
+
+				std::size_t column(std::uint64_t h, std::size_t row) const {
+					std::uint32_t mixed = std::uint32_t(h) + std::uint32_t(row) * (std::uint32_t(h >> 32) | 1);
+					// Maps `mixed` uniformly onto `[0, width_)` without a division.
+					return std::size_t((std::uint64_t(mixed) * width_) >> 32);
+				}
+
+				void update(std::uint64_t h, std::uint64_t count) {
+					for(std::size_t row = 0; row < depth_; ++row) {
+						counters_[row * width_ + column(h, row)] += count;
+					}
+				}
+			public:
+				CountMinSketch(std::size_t width, std::size_t depth, H hash = H())
+				: width_(width), depth_(depth), total_(0), hash_(std::move(hash)) {
+					if(!width || !depth || width > std::numeric_limits<std::uint32_t>::max()) {
+						throw std::invalid_argument("CountMinSketch: width must be in [1, 2^32), and depth positive");
+					}
+					counters_.assign(width * depth, 0);
+				}
+
+				/// A sketch overcounting by at most `epsilon * total()` with probability `1 - delta`.
+				static CountMinSketch withError(double epsilon, double delta, H hash = H()) {
+					if(!(epsilon > 0) || !(delta > 0 && delta < 1)) {
+						throw std::invalid_argument("CountMinSketch::withError: need epsilon > 0 and 0 < delta < 1");
+					}
+					return CountMinSketch(std::size_t(std::ceil(std::exp(1.0) / epsilon)), std::size_t(std::ceil(std::log(1 / delta))), std::move(hash));
+				}
+
+				std::size_t width() const {
+					return width_;
+				}
+
+				std::size_t depth() const {
+					return depth_;
+				}
+
+				/// The total count of everything added.
+				std::uint64_t total() const {
+					return total_;
+				}
+
+				void add(const E& e, std::uint64_t count = 1) {
+					update(hash_(e), count);
+					total_ += count;
+				}
+
+				/// Add every element of `[first, last)` once, hashing them a block at a time.
+				template<class It>
+				void addBatch(It first, It last) {
+					detail::forEachHashBlock(hash_, first, last, [&](const std::uint64_t* hashes, std::size_t n){
+						for(std::size_t row = 0; row < depth_; ++row) {
+							std::uint64_t *counters = &counters_[row * width_];
+							for(std::size_t i = 0; i < n; ++i) {
+								++counters[column(hashes[i], row)];
+							}
+						}
+						total_ += n;
+					});
+				}
+
+				/// Fold `other`'s counts into this sketch. Throws `std::invalid_argument` if the shapes differ.
+				void merge(const CountMinSketch& other) {
+					if(other.width_ != width_ || other.depth_ != depth_) {
+						throw std::invalid_argument("CountMinSketch::merge: shapes differ");
+					}
+					for(std::size_t i = 0; i < counters_.size(); ++i) {
+						counters_[i] += other.counters_[i];
+					}
+					total_ += other.total_;
+				}
+
+				/// An upper bound on the number of times `e` was added, which is usually tight.
+				std::uint64_t estimate(const E& e) const {
+					std::uint64_t h = hash_(e);
+					std::uint64_t best = std::numeric_limits<std::uint64_t>::max();
+					for(std::size_t row = 0; row < depth_; ++row) {
+						best = std::min(best, counters_[row * width_ + column(h, row)]);
+					}
+					return best;
+				}
+			};
+
+			/**************************************************
+			 * A merging t-digest, estimating quantiles of a
+			 * distribution of `double`s in memory proportional to
+			 * `compression`, with accuracy that is best in the tails.
+			 *
+			 * Values are buffered, and periodically sorted and merged
+			 * into centroids, whose sizes are bounded by the `k1`
+			 * scale function `compression / (2 pi) * asin(2q - 1)`,
+			 * so centroids near the extremes stay small. Merging
+			 * another digest feeds its centroids through the same
+			 * path, so per-shard digests combine with the same
+			 * accuracy guarantee.
+			 **************************************************/
+			class TDigest {
+				struct Centroid {
+					double mean;
+					double weight;
+
+					bool operator<(const Centroid& other) const {
+						return mean < other.mean;
+					}
+				};
+
+				double compression_;
+				mutable std::vector<Centroid> centroids_;
+				mutable std::vector<Centroid> buffer_;
+				mutable std::vector<Centroid> scratch_;
+				double total_;
+				double min_;
+				double max_;
+
+				double k(double q) const {
+					return compression_ / (2 * detail::kPi) * std::asin(2 * q - 1);
+				}
+
+				double kInverse(double k) const {
+					return (std::sin(std::min(std::max(k * 2 * detail::kPi / compression_, -detail::kPi / 2), detail::kPi / 2)) + 1) / 2;
+				}
+
+				/// Merge `buffer_` into `centroids_`.
+				void compress() const {
+					if(buffer_.empty()) {
+						return;
+					}
+					buffer_.insert(buffer_.end(), centroids_.begin(), centroids_.end());
+					std::sort(buffer_.begin(), buffer_.end());
+					scratch_.clear();
+					Centroid current = buffer_.front();
+					double before = 0; // Weight of the centroids already emitted.
+					double limit = total_ * kInverse(k(0) + 1);
+					for(std::size_t i = 1; i < buffer_.size(); ++i) {
+						const Centroid& next = buffer_[i];
+						if(before + current.weight + next.weight <= limit) {
+							current.weight += next.weight;
+							current.mean += (next.mean - current.mean) * next.weight / current.weight;
+						} else {
+							before += current.weight;
+							scratch_.push_back(current);
+							limit = total_ * kInverse(k(before / total_) + 1);
+							current = next;
+						}
+					}
+					scratch_.push_back(current);
+					std::swap(centroids_, scratch_);
+					buffer_.clear();
+				}
+
+				void push(double mean, double weight) {
+					buffer_.push_back(Centroid{mean, weight});
+					total_ += weight;
+					if(buffer_.size() >= buffer_.capacity()) {
+						compress();
+					}
+				}
+			public:
+				explicit TDigest(double compression = 100)
+				: compression_(compression), total_(0), min_(std::numeric_limits<double>::infinity()), max_(-std::numeric_limits<double>::infinity()) {
+					if(!(compression >= 10)) {
+						throw std::invalid_argument("TDigest: compression must be at least 10");
+					}
+					buffer_.reserve(std::size_t(5 * compression));
+				}
+
+				double compression() const {
+					return compression_;
+				}
+
+				/// The total weight added.
+				double count() const {
+					return total_;
+				}
+
+				double min() const {
+					return min_;
+				}
+
+				double max() const {
+					return max_;
+				}
+
+				void add(double x, double weight = 1) {
+					min_ = std::min(min_, x);
+					max_ = std::max(max_, x);
+					push(x, weight);
+				}
+
+				/// Add every value of `[first, last)` with weight 1.
+				template<class It>
+				void addBatch(It first, It last) {
+					for(; first != last; ++first) {
+						add(double(*first));
+					}
+				}
+
+				/// Fold `other`'s distribution into this digest.
+				void merge(const TDigest& other) {
+					other.compress();
+					min_ = std::min(min_, other.min_);
+					max_ = std::max(max_, other.max_);
+					for(const Centroid& c : other.centroids_) {
+						push(c.mean, c.weight);
+					}
+				}
+
+				/// The number of centroids retained, once pending values are merged.
+				std::size_t size() const {
+					compress();
+					return centroids_.size();
+				}
+
+				/**************************************************
+				 * The estimated `q`-quantile, for `q` in `[0, 1]`,
+				 * interpolating between centroid means (and the
+				 * exact extremes). NaN if the digest is empty.
+				 **************************************************/
+				double quantile(double q) const {
+					compress();
+					if(centroids_.empty()) {
+						return std::numeric_limits<double>::quiet_NaN();
+					}
+					q = std::min(std::max(q, 0.0), 1.0);
+					double index = q * total_;
+					const Centroid& first = centroids_.front();
+					if(index < first.weight / 2) {
+						return min_ + (first.mean - min_) * index / (first.weight / 2);
+					}
+					double before = 0;
+					for(std::size_t i = 0; i + 1 < centroids_.size(); ++i) {
+						const Centroid& a = centroids_[i];
+						const Centroid& b = centroids_[i + 1];
+						double from = before + a.weight / 2;
+						double to = before + a.weight + b.weight / 2;
+						if(index <= to) {
+							return a.mean + (b.mean - a.mean) * (index - from) / (to - from);
+						}
+						before += a.weight;
+					}
+					const Centroid& last = centroids_.back();
+					double from = total_ - last.weight / 2;
+					return index <= from ? last.mean : last.mean + (max_ - last.mean) * (index - from) / (total_ - from);
+				}
+			};
+
+			/**************************************************
+			 * A scalable Bloom filter (Almeida et al.): approximate
+			 * set membership, with no false negatives, and a false
+			 * positive rate below `falsePositiveRate` however many
+			 * elements are added.
+			 *
+			 * It is a series of Bloom filters, each twice the capacity
+			 * of the last, with a false positive rate halving from
+			 * one to the next, so that the rates sum to the target.
+			 * Only the newest filter is added to, and a new one is
+			 * begun once it holds its capacity. Memory grows by
+			 * O(log(1 / falsePositiveRate)) bits per distinct element
+			 * (a few bytes, as each filter's size is rounded up to a
+			 * power of two): far less than storing them.
+			 *
+			 * Each probe position is derived from a single hash of
+			 * the element by double hashing.
+			 **************************************************/
+			template<class E, class H = detail::Hash<E>>
+			class ScalableBloomFilter {
+				struct Stage {
+					std::vector<std::uint64_t> bits;
+					std::uint64_t mask; ///< The number of bits, less one. A power of two.
+					unsigned hashes;
+					std::size_t capacity;
+					std::size_t count;
+
+					Stage(std::size_t capacity, double falsePositiveRate)
+					: hashes(unsigned(std::ceil(-std::log2(falsePositiveRate)))), capacity(capacity), count(0) {
+						double ln2 = std::log(2.0);
+						double wanted = std::ceil(-double(capacity) * std::log(falsePositiveRate) / (ln2 * ln2));
+						std::uint64_t size = 64;
+						while(double(size) < wanted) {
+							size <<= 1;
+						}
+						mask = size - 1;
+						bits.assign(std::size_t(size / 64), 0);
+					}
+
+					template<class F>
+					bool probe(std::uint64_t h, F && f) const {
+						std::uint64_t step = ((h >> 32) | (h << 32)) | 1;
+						for(unsigned i = 0; i < hashes; ++i, h += step) {
+							if(!f(h & mask)) {
+								return false;
+							}
+						}
+						return true;
+					}
+
+					bool contains(std::uint64_t h) const {
+						return probe(h, [&](std::uint64_t bit){
+							return (bits[bit >> 6] >> (bit & 63)) & 1;
+						});
+					}
+
+					void add(std::uint64_t h) {
+						probe(h, [&](std::uint64_t bit){
+							bits[bit >> 6] |= std::uint64_t(1) << (bit & 63);
+							return true;
+						});
+						++count;
+					}
+				};
+
+				double falsePositiveRate_;
+				std::vector<Stage> stages_;
+				H hash_;
+
+				bool containsHash(std::uint64_t h) const {
+					for(const Stage& stage : stages_) {
+						if(stage.contains(h)) {
+							return true;
+						}
+					}
+					return false;
+				}
+			public:
+				/// `initialCapacity` is the number of elements the first filter holds before another is added.
+				explicit ScalableBloomFilter(std::size_t initialCapacity = 1024, double falsePositiveRate = 0.001, H hash = H())
+				: falsePositiveRate_(falsePositiveRate), hash_(std::move(hash)) {
+					if(!initialCapacity || !(falsePositiveRate > 0 && falsePositiveRate < 1)) {
+						throw std::invalid_argument("ScalableBloomFilter: need a positive capacity, and 0 < falsePositiveRate < 1");
+					}
+					stages_.emplace_back(initialCapacity, falsePositiveRate / 2);
+				}
+
+				/// Whether `e` may have been added. Never false for an element which was.
+				bool contains(const E& e) const {
+					return containsHash(hash_(e));
+				}
+
+				/// Add `e`, and return whether it was (definitely) not already present.
+				bool insert(const E& e) {
+					std::uint64_t h = hash_(e);
+					if(containsHash(h)) {
+						return false;
+					}
+					if(stages_.back().count >= stages_.back().capacity) {
+						double rate = falsePositiveRate_ / double(std::uint64_t(2) << stages_.size());
+						stages_.emplace_back(2 * stages_.back().capacity, rate);
+					}
+					stages_.back().add(h);
+					return true;
+				}
+
+				void add(const E& e) {
+					insert(e);
+				}
+
+				/// The memory used by the filters, in bytes.
+				std::size_t bytes() const {
+					std::size_t total = 0;
+					for(const Stage& stage : stages_) {
+						total += stage.bits.size() * sizeof(std::uint64_t);
+					}
+					return total;
+				}
+			};
+
+			/**************************************************
+			 * Feed every element of `source` to `sketch` (anything
+			 * with an `add(const E&)`, such as `HyperLogLog`,
+			 * `CountMinSketch`, `TDigest` or `ScalableBloomFilter`),
+			 * and return it.
+			 *
+			 * `source` is taken by rvalue, and each cell is released
+			 * once visited, so this runs in constant memory when the
+			 * caller holds no other reference to the `Stream`.
+			 **************************************************/
+			template<class E, class Sketch>
+			Sketch sketch(std::shared_ptr<Stream<E>> && source, Sketch state) {
+				detail::consumeStream(std::move(source), [&](const E& e){
+					state.add(e);
+				});
+				return state;
+			}
+
+			/**************************************************
+			 * As `sketch`, for a `Stream` of chunks (any range, such as
+			 * those from `SpscChannel::chunks`), which are fed whole to
+			 * `Sketch::addBatch`.
+			 **************************************************/
+			template<class C, class Sketch>
+			Sketch sketchChunks(std::shared_ptr<Stream<C>> && chunks, Sketch state) {
+				detail::consumeStream(std::move(chunks), [&](const C& chunk){
+					state.addBatch(std::begin(chunk), std::end(chunk));
+				});
+				return state;
+			}
+
+			/**************************************************
+			 * A lazy `Stream` of snapshots of `sketch`, taken after
+			 * every `interval` elements of `source` (and after the
+			 * last, if that leaves a partial interval). Each snapshot
+			 * is a copy, so choose `interval` with the sketch's
+			 * size in mind.
+			 **************************************************/
+			template<class E, class Sketch>
+			std::shared_ptr<Stream<Sketch>> sketchScan(std::shared_ptr<Stream<E>> source, Sketch sketch, std::size_t interval = 1) {
+				if(!interval) {
+					throw std::invalid_argument("sketchScan: the interval must be positive");
+				}
+				return Stream<Sketch>::Generate([input = detail::StreamGen<std::shared_ptr<Stream<E>>>(std::move(source)), sketch = std::move(sketch), interval]() mutable -> std::optional<Sketch> {
+					std::size_t n = 0;
+					for(; n < interval; ++n) {
+						auto e = input();
+						if(!e) {
+							break;
+						}
+						sketch.add(*e);
+					}
+					return n ? std::optional<Sketch>(sketch) : std::nullopt;
+				});
+			}
+		}
+	}
+}
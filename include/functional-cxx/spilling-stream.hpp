@@ -0,0 +1,247 @@
+#pragma once
+/************************************************************************************
+ *
+ * Author: Thomas Dickerson
+ * Copyright: 2021, Geopipe, Inc.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ************************************************************************************/
+
+#include <algorithm>
+#include <cstddef>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <optional>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+#include <functional-cxx/stream.hpp>
+#include <functional-cxx/support/generators.hpp>
+#include <functional-cxx/support/serialization.hpp>
+
+namespace com {
+	namespace geopipe {
+		/**************************************************
+		 * Tools for functional programming
+		 **************************************************/
+		namespace functional {
+			/**************************************************
+			 * Internal implementation details
+			 **************************************************/
+			namespace detail {
+				/**************************************************
+				 * The state shared by every traversal of a
+				 * `SpillingStream`: the source, positioned after the
+				 * last element forced by any traversal; a resident
+				 * prefix of the forced elements; and a file holding
+				 * the rest, in order, which is only ever appended to.
+				 **************************************************/
+				template<class E, class Serializer>
+				class SpillState {
+					StreamGen<std::shared_ptr<Stream<E>>> source_;
+					bool exhausted_ = false;
+					std::vector<E> resident_;
+					std::size_t residentCapacity_;
+					Serializer serializer_;
+					std::filesystem::path directory_;
+					std::size_t bufferSize_;
+					std::unique_ptr<SpillFile> file_;
+					std::unique_ptr<char[]> buffer_;
+					std::ofstream out_;
+					std::size_t spilled_ = 0; ///< Elements written to `out_`.
+					std::size_t flushed_ = 0; ///< Elements readable from the file.
+
+					void spill(const E& e) {
+						if(!file_) {
+							file_ = std::make_unique<SpillFile>(directory_, "functional-cxx-spill");
+							buffer_.reset(new char[bufferSize_]);
+							out_.rdbuf()->pubsetbuf(buffer_.get(), std::streamsize(bufferSize_));
+							out_.open(file_->path(), std::ios::binary | std::ios::trunc);
+						}
+						serializer_.write(out_, e);
+						if(!out_) {
+							throw std::runtime_error("spillingStream: failed writing " + file_->path().string());
+						}
+						++spilled_;
+					}
+				public:
+					SpillState(std::shared_ptr<Stream<E>> && source, std::size_t residentCapacity, std::filesystem::path && directory, Serializer && serializer, std::size_t bufferSize)
+					: source_(std::move(source)), residentCapacity_(residentCapacity), serializer_(std::move(serializer)), directory_(std::move(directory)), bufferSize_(std::max<std::size_t>(bufferSize, 1)) {}
+
+					/// Force the next element of the source, and record it.
+					std::optional<E> pull() {
+						if(exhausted_) {
+							return std::nullopt;
+						}
+						std::optional<E> e = source_();
+						if(!e) {
+							exhausted_ = true;
+						} else if(!spilled_ && resident_.size() < residentCapacity_) {
+							resident_.push_back(*e);
+						} else {
+							spill(*e);
+						}
+						return e;
+					}
+
+					/// Make every spilled element readable from the file.
+					void flush() {
+						if(flushed_ < spilled_) {
+							out_.flush();
+							if(!out_) {
+								throw std::runtime_error("spillingStream: failed writing " + file_->path().string());
+							}
+							flushed_ = spilled_;
+						}
+					}
+
+					/// The position in the file just past the last spilled element.
+					std::streampos end() {
+						return out_.tellp();
+					}
+
+					const std::vector<E>& resident() const {
+						return resident_;
+					}
+
+					std::size_t spilled() const {
+						return spilled_;
+					}
+
+					const SpillFile& file() const {
+						return *file_;
+					}
+
+					const Serializer& serializer() const {
+						return serializer_;
+					}
+
+					std::size_t bufferSize() const {
+						return bufferSize_;
+					}
+				};
+
+				/**************************************************
+				 * Yields the elements of a `SpillState` from the first:
+				 * the resident prefix, then the file, then (once it
+				 * catches up with the furthest traversal) the source.
+				 **************************************************/
+				template<class E, class Serializer>
+				class SpillReader {
+					std::shared_ptr<SpillState<E, Serializer>> state_;
+					std::size_t index_ = 0;
+					Serializer serializer_;
+					std::unique_ptr<char[]> buffer_;
+					std::unique_ptr<std::ifstream> in_;
+					std::optional<std::streampos> seek_; ///< Where to resume reading, after elements pulled from the source directly.
+				public:
+					explicit SpillReader(std::shared_ptr<SpillState<E, Serializer>> state)
+					: state_(std::move(state)), serializer_(state_->serializer()) {}
+
+					std::optional<E> operator()() {
+						SpillState<E, Serializer>& s = *state_;
+						std::size_t i = index_++;
+						if(i < s.resident().size()) {
+							return s.resident()[i];
+						}
+						i -= s.resident().size();
+						if(i < s.spilled()) {
+							s.flush();
+							if(!in_) {
+								buffer_.reset(new char[s.bufferSize()]);
+								in_ = std::make_unique<std::ifstream>();
+								in_->rdbuf()->pubsetbuf(buffer_.get(), std::streamsize(s.bufferSize()));
+								in_->open(s.file().path(), std::ios::binary);
+							}
+							if(seek_) {
+								in_->seekg(*seek_);
+								seek_.reset();
+							}
+							std::optional<E> e = serializer_.read(*in_);
+							if(!e) {
+								throw std::runtime_error("spillingStream: failed reading " + s.file().path().string());
+							}
+							return e;
+						}
+						std::optional<E> e = s.pull();
+						if(e && s.spilled()) {
+							seek_ = s.end();
+						}
+						return e;
+					}
+				};
+			}
+
+			/**************************************************
+			 * A `Stream` which may be traversed any number of times,
+			 * without keeping its forced elements in memory: those
+			 * beyond a memory budget are written to a temporary file
+			 * as they are forced, and read back by later traversals.
+			 *
+			 * Retaining the head of an ordinary `Stream` for a second
+			 * pass retains every cell forced since. Instead, retain
+			 * this, and call `stream` for each pass: each is a fresh
+			 * `Stream` of the same elements, which (walked in the
+			 * usual sliding-window fashion) holds one cell, and a
+			 * read buffer once it reaches the spilled elements. The
+			 * source is forced lazily, once per element, by whichever
+			 * traversal gets furthest, so traversals may interleave.
+			 *
+			 * Copies share the same state and file, which is removed
+			 * once the last copy and traversal are released. Like
+			 * `Stream`, this is not thread-safe.
+			 **************************************************/
+			template<class E, class Serializer = BinarySerializer<E>>
+			class SpillingStream {
+				std::shared_ptr<detail::SpillState<E, Serializer>> state_;
+			public:
+				explicit SpillingStream(std::shared_ptr<detail::SpillState<E, Serializer>> state)
+				: state_(std::move(state)) {}
+
+				/// A new traversal, from the first element.
+				std::shared_ptr<Stream<E>> stream() const {
+					return Stream<E>::Generate(detail::SpillReader<E, Serializer>(state_));
+				}
+
+				/// The number of elements held in memory.
+				std::size_t resident() const {
+					return state_->resident().size();
+				}
+
+				/// The number of elements written to disk.
+				std::size_t spilled() const {
+					return state_->spilled();
+				}
+			};
+
+			/**************************************************
+			 * Make `source` re-traversable in bounded memory: see
+			 * `SpillingStream`. The first `memoryBudget / sizeof(E)`
+			 * elements forced are kept in memory, and the rest are
+			 * written with `serializer` to a file in `tmpdir`, which
+			 * is only created if needed. `source` should not be
+			 * retained elsewhere, or its cells will be too.
+			 **************************************************/
+			template<class E, class Serializer = BinarySerializer<E>>
+			SpillingStream<E, Serializer> spillingStream(std::shared_ptr<Stream<E>> source, std::size_t memoryBudget,
+			                                             std::filesystem::path tmpdir = std::filesystem::temp_directory_path(),
+			                                             Serializer serializer = Serializer(), std::size_t ioBufferSize = std::size_t(1) << 16) {
+				return SpillingStream<E, Serializer>(std::make_shared<detail::SpillState<E, Serializer>>(std::move(source), memoryBudget / sizeof(E), std::move(tmpdir), std::move(serializer), ioBufferSize));
+			}
+		}
+	}
+}
@@ -0,0 +1,238 @@
+#pragma once
+/************************************************************************************
+ *
+ * Author: Thomas Dickerson
+ * Copyright: 2021, Geopipe, Inc.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ************************************************************************************/
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <optional>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+#include <functional-cxx/stream.hpp>
+#include <functional-cxx/support/memory-hacks.hpp>
+#include <functional-cxx/support/parking.hpp>
+
+namespace com {
+	namespace geopipe {
+		/**************************************************
+		 * Tools for functional programming
+		 **************************************************/
+		namespace functional {
+			/**************************************************
+			 * A bounded, lock-free, single-producer/single-consumer
+			 * ring buffer whose consumer side can be viewed as a `Stream`.
+			 *
+			 * One thread calls `SpscChannel::push` and finally
+			 * `SpscChannel::close`; one other thread consumes, either
+			 * directly with `SpscChannel::pop`, or through
+			 * `SpscChannel::stream`/`SpscChannel::chunks`.
+			 * Each side keeps a cached copy of the other side's index,
+			 * so in steady state a transfer touches no shared cache line
+			 * except the slot itself.
+			 *
+			 * Both sides spin briefly and then park when the buffer
+			 * is full (respectively empty).
+			 *
+			 * Must be owned by a `std::shared_ptr`, since the
+			 * `Stream` views keep the channel alive.
+			 *
+			 * @warning If the consumer abandons the channel before it is
+			 * closed, a producer blocked in `SpscChannel::push` will never wake.
+			 **************************************************/
+			template<class E>
+			class SpscChannel : public std::enable_shared_from_this<SpscChannel<E>> {
+				using StreamT = std::shared_ptr<Stream<E>>;
+				using ChunkStreamT = std::shared_ptr<Stream<std::vector<E>>>;
+
+				const std::size_t mask_;
+				const std::size_t spins_;
+				std::unique_ptr<detail::AlignedFor<E>[]> slots_;
+
+				// Consumer-owned line
+				alignas(detail::kCacheLineSize) std::atomic<std::size_t> head_;
+				std::size_t cachedTail_;
+				// Producer-owned line
+				alignas(detail::kCacheLineSize) std::atomic<std::size_t> tail_;
+				std::size_t cachedHead_;
+				alignas(detail::kCacheLineSize) std::atomic<bool> closed_;
+
+				detail::Parker notEmpty_;
+				detail::Parker notFull_;
+
+				static std::size_t roundUpPow2(std::size_t n) {
+					std::size_t result = 1;
+					while(result < n) {
+						result <<= 1;
+					}
+					return result;
+				}
+
+				E* slot(std::size_t i) {
+					return std::launder(reinterpret_cast<E*>(&slots_[i & mask_]));
+				}
+
+				bool readable() {
+					if(cachedTail_ == head_.load(std::memory_order_relaxed)) {
+						cachedTail_ = tail_.load(std::memory_order_acquire);
+					}
+					return cachedTail_ != head_.load(std::memory_order_relaxed);
+				}
+
+				bool writable() {
+					std::size_t tail = tail_.load(std::memory_order_relaxed);
+					if(tail - cachedHead_ > mask_) {
+						cachedHead_ = head_.load(std::memory_order_acquire);
+					}
+					return tail - cachedHead_ <= mask_;
+				}
+
+				/// @pre `readable()` returned `true`.
+				E take() {
+					std::size_t head = head_.load(std::memory_order_relaxed);
+					E* e = slot(head);
+					E result(std::move(*e));
+					e->~E();
+					head_.store(head + 1, std::memory_order_release);
+					notFull_.notify();
+					return result;
+				}
+
+			public:
+				/**************************************************
+				 * @arg capacity is rounded up to a power of two.
+				 * @arg spins is the number of polls before a blocked
+				 * side parks on a condition variable.
+				 **************************************************/
+				explicit SpscChannel(std::size_t capacity = 1024, std::size_t spins = 1024)
+				: mask_(roundUpPow2(capacity ? capacity : 1) - 1), spins_(spins), slots_(new detail::AlignedFor<E>[mask_ + 1]),
+				  head_(0), cachedTail_(0), tail_(0), cachedHead_(0), closed_(false) {}
+
+				SpscChannel(const SpscChannel&) = delete;
+				SpscChannel& operator=(const SpscChannel&) = delete;
+
+				~SpscChannel() {
+					for(std::size_t i = head_.load(std::memory_order_relaxed), end = tail_.load(std::memory_order_relaxed); i != end; ++i) {
+						slot(i)->~E();
+					}
+				}
+
+				/// Producer side: enqueue `e` if there is room, without blocking.
+				template<class A>
+				bool tryPush(A && e) {
+					if(closed_.load(std::memory_order_relaxed)) {
+						throw std::logic_error("SpscChannel::push after SpscChannel::close");
+					}
+					if(!writable()) {
+						return false;
+					}
+					std::size_t tail = tail_.load(std::memory_order_relaxed);
+					new (slot(tail)) E(std::forward<A>(e));
+					tail_.store(tail + 1, std::memory_order_release);
+					notEmpty_.notify();
+					return true;
+				}
+
+				/// Producer side: enqueue `e`, waiting for room if necessary.
+				template<class A>
+				void push(A && e) {
+					if(!writable()) {
+						notFull_.wait([this](){ return writable(); }, spins_);
+					}
+					tryPush(std::forward<A>(e));
+				}
+
+				/// Producer side: signal end-of-stream. No more values may be pushed.
+				void close() {
+					closed_.store(true, std::memory_order_release);
+					notEmpty_.notify();
+				}
+
+				/// Consumer side: dequeue a value if one is ready, without blocking.
+				std::optional<E> tryPop() {
+					if(readable()) {
+						return take();
+					}
+					return std::nullopt;
+				}
+
+				/**************************************************
+				 * Consumer side: dequeue a value, waiting if necessary.
+				 * Returns an empty optional once the channel has been
+				 * closed and drained.
+				 **************************************************/
+				std::optional<E> pop() {
+					if(!readable()) {
+						notEmpty_.wait([this](){ return readable() || closed_.load(std::memory_order_acquire); }, spins_);
+						// `close` happens-after the final push, so this re-check cannot miss it.
+						if(!readable()) {
+							return std::nullopt;
+						}
+					}
+					return take();
+				}
+
+				/**************************************************
+				 * Consumer side: wait for at least one value, then
+				 * dequeue as many as are ready, up to `maxBatch`, into `out`.
+				 * Returns `false` once the channel has been closed and drained.
+				 **************************************************/
+				bool popBatch(std::vector<E> &out, std::size_t maxBatch) {
+					std::optional<E> first = pop();
+					if(!first) {
+						return false;
+					}
+					out.push_back(std::move(*first));
+					while(out.size() < maxBatch && readable()) {
+						out.push_back(take());
+					}
+					return true;
+				}
+
+				/**************************************************
+				 * Consumer side: view the channel as a `Stream`.
+				 * Obtaining the `Stream` blocks until the first element
+				 * is available (or the channel is closed), and each
+				 * `Stream::tail` force blocks for the following one.
+				 **************************************************/
+				StreamT stream() {
+					return Stream<E>::Generate([self = this->shared_from_this()](){
+						return self->pop();
+					});
+				}
+
+				/**************************************************
+				 * Consumer side: view the channel as a `Stream` of chunks
+				 * of up to `maxBatch` elements, amortizing the per-cell
+				 * allocation of `Stream` over everything that was ready.
+				 **************************************************/
+				ChunkStreamT chunks(std::size_t maxBatch = 256) {
+					return Stream<std::vector<E>>::Generate([self = this->shared_from_this(), maxBatch](){
+						std::vector<E> chunk;
+						chunk.reserve(maxBatch);
+						return self->popBatch(chunk, maxBatch) ? std::optional<std::vector<E>>(std::move(chunk)) : std::nullopt;
+					});
+				}
+			};
+		}
+	}
+}
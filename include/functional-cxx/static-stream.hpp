@@ -0,0 +1,232 @@
+#pragma once
+/************************************************************************************
+ *
+ * Author: Thomas Dickerson
+ * Copyright: 2021, Geopipe, Inc.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ************************************************************************************/
+
+#include <cstddef>
+#include <memory>
+#include <optional>
+#include <type_traits>
+#include <utility>
+
+#include <functional-cxx/stream.hpp>
+#include <functional-cxx/support/generators.hpp>
+#include <functional-cxx/support/unique-function.hpp>
+
+namespace com {
+	namespace geopipe {
+		/**************************************************
+		 * Tools for functional programming
+		 **************************************************/
+		namespace functional {
+			/**************************************************
+			 * A single-pass stream whose whole pipeline is part of
+			 * its type.
+			 *
+			 * Every `Stream` cell stores its thunk behind a type-erased
+			 * `UniqueFunction`, so the compiler can never see through
+			 * one stage into the next. A `StaticStream` instead holds
+			 * its generator (see `Stream::Generate`) by value, and each
+			 * combinator wraps it in another, so `map`/`filter`/`take`
+			 * pipelines consumed with `forEach`, `fold` or a range-`for`
+			 * compile down to one loop, with no allocation at all.
+			 *
+			 * Since nothing is memoized, a `StaticStream` can only be
+			 * traversed once, and its combinators consume it
+			 * (they are `&&`-qualified). Call `erase` to obtain an
+			 * ordinary `Stream` at an API boundary, or `ephemeral` to
+			 * obtain an `EphemeralStream` if single-pass is enough.
+			 **************************************************/
+			template<class E, class Gen>
+			class StaticStream;
+
+			/**************************************************
+			 * A single-pass stream with a nameable type, for passing
+			 * ephemeral pipelines across API boundaries.
+			 *
+			 * This is a `StaticStream` whose generator is type-erased
+			 * as a whole: there is one virtual call per element, but,
+			 * unlike `Stream`, no allocation and no memoization per
+			 * element, since all the pipeline's state is mutated in
+			 * place. It shares the combinators of `StaticStream`, and
+			 * `erase` converts it to a memoized `Stream` only when
+			 * persistence or multiple passes are actually needed.
+			 **************************************************/
+			template<class E>
+			using EphemeralStream = StaticStream<E, detail::UniqueFunction<std::optional<E>()>>;
+
+			template<class E, class Gen>
+			class StaticStream {
+				Gen gen_;
+			public:
+				using value_type = E;
+
+				/// Input iterator for range-`for`.
+				class Iterator {
+					friend class StaticStream;
+					Gen *gen_;
+					std::optional<E> current_;
+
+					Iterator() : gen_(nullptr) {}
+					explicit Iterator(Gen *gen) : gen_(gen), current_((*gen)()) {}
+				public:
+					E& operator*() {
+						return *current_;
+					}
+
+					Iterator& operator++() {
+						current_ = (*gen_)();
+						return *this;
+					}
+
+					bool operator!=(const Iterator&) const {
+						return current_.has_value();
+					}
+				};
+
+				explicit StaticStream(Gen gen)
+				: gen_(std::move(gen)) {}
+
+				/// Pull the next element, if any.
+				std::optional<E> next() {
+					return gen_();
+				}
+
+				/// @warning Begins consuming the stream, so it may only be called once.
+				Iterator begin() {
+					return Iterator(&gen_);
+				}
+
+				/// Past-the-end iterator. Comparison only asks whether the other iterator is exhausted.
+				Iterator end() {
+					return Iterator();
+				}
+
+				template<class Transform>
+				StaticStream<typename detail::MapGen<Gen, std::decay_t<Transform>>::value_type, detail::MapGen<Gen, std::decay_t<Transform>>> map(Transform && transform) && {
+					using G = detail::MapGen<Gen, std::decay_t<Transform>>;
+					return StaticStream<typename G::value_type, G>(G(std::move(gen_), std::decay_t<Transform>(std::forward<Transform>(transform))));
+				}
+
+				template<class Predicate>
+				StaticStream<E, detail::FilterGen<Gen, std::decay_t<Predicate>>> filter(Predicate && predicate) && {
+					using G = detail::FilterGen<Gen, std::decay_t<Predicate>>;
+					return StaticStream<E, G>(G(std::move(gen_), std::decay_t<Predicate>(std::forward<Predicate>(predicate))));
+				}
+
+				/// At most the first `n` elements. The source is not pulled past them.
+				StaticStream<E, detail::TakeGen<Gen>> take(std::size_t n) && {
+					return StaticStream<E, detail::TakeGen<Gen>>(detail::TakeGen<Gen>(std::move(gen_), n));
+				}
+
+				/**************************************************
+				 * Elements while they satisfy `predicate`. The source
+				 * is not pulled past the first which does not.
+				 **************************************************/
+				template<class Predicate>
+				StaticStream<E, detail::TakeWhileGen<Gen, std::decay_t<Predicate>>> takeWhile(Predicate && predicate) && {
+					using G = detail::TakeWhileGen<Gen, std::decay_t<Predicate>>;
+					return StaticStream<E, G>(G(std::move(gen_), std::decay_t<Predicate>(std::forward<Predicate>(predicate))));
+				}
+
+				/// Invoke `f` on every element.
+				template<class F>
+				void forEach(F && f) && {
+					while(auto e = gen_()) {
+						f(std::move(*e));
+					}
+				}
+
+				/// Left fold: `op(op(op(init, e0), e1), ...)`.
+				template<class A, class Op>
+				A fold(A init, Op && op) && {
+					while(auto e = gen_()) {
+						init = op(std::move(init), std::move(*e));
+					}
+					return init;
+				}
+
+				/// Number of remaining elements.
+				std::size_t count() && {
+					std::size_t n = 0;
+					while(gen_()) {
+						++n;
+					}
+					return n;
+				}
+
+				/**************************************************
+				 * Type-erase into an ordinary memoized `Stream`, which
+				 * forces this pipeline one element at a time as its
+				 * cells are forced.
+				 **************************************************/
+				std::shared_ptr<Stream<E>> erase() && {
+					return Stream<E>::Generate(std::move(gen_));
+				}
+
+				/// Type-erase the pipeline (but not its elements) into an `EphemeralStream`.
+				EphemeralStream<E> ephemeral() && {
+					return EphemeralStream<E>(detail::UniqueFunction<std::optional<E>()>(std::move(gen_)));
+				}
+			};
+
+			/// A `StaticStream` drawing its elements from `generator`.
+			template<class Gen>
+			StaticStream<detail::GeneratedT<std::decay_t<Gen>>, std::decay_t<Gen>> staticStream(Gen && generator) {
+				return StaticStream<detail::GeneratedT<std::decay_t<Gen>>, std::decay_t<Gen>>(std::forward<Gen>(generator));
+			}
+
+			/// A `StaticStream` of copies of the elements of `[first, last)`.
+			template<class It, class Sentinel>
+			StaticStream<typename detail::IteratorGen<It, Sentinel>::value_type, detail::IteratorGen<It, Sentinel>> staticRange(It first, Sentinel last) {
+				using G = detail::IteratorGen<It, Sentinel>;
+				return StaticStream<typename G::value_type, G>(G(std::move(first), std::move(last)));
+			}
+
+			/**************************************************
+			 * A `StaticStream` of successive `step(state)`, until it
+			 * returns an empty optional. `state` is a single object,
+			 * mutated in place by `step`, rather than rebuilt per element.
+			 **************************************************/
+			template<class S, class Step>
+			StaticStream<typename detail::UnfoldGen<S, std::decay_t<Step>>::value_type, detail::UnfoldGen<S, std::decay_t<Step>>> unfold(S state, Step && step) {
+				using G = detail::UnfoldGen<S, std::decay_t<Step>>;
+				return StaticStream<typename G::value_type, G>(G(std::move(state), std::decay_t<Step>(std::forward<Step>(step))));
+			}
+
+			/// The unbounded `StaticStream` `seed`, `f(seed)`, `f(f(seed))`, ...
+			template<class E, class F>
+			StaticStream<E, detail::IterateGen<E, std::decay_t<F>>> iterate(E seed, F && f) {
+				using G = detail::IterateGen<E, std::decay_t<F>>;
+				return StaticStream<E, G>(G(std::move(seed), std::decay_t<F>(std::forward<F>(f))));
+			}
+
+			/**************************************************
+			 * A single pass over an existing `Stream`, which retains
+			 * only the current cell, so that (unless retained elsewhere)
+			 * cells are reclaimed as soon as they have been visited.
+			 **************************************************/
+			template<class E>
+			StaticStream<E, detail::StreamGen<std::shared_ptr<Stream<E>>>> fromStream(std::shared_ptr<Stream<E>> stream) {
+				using G = detail::StreamGen<std::shared_ptr<Stream<E>>>;
+				return StaticStream<E, G>(G(std::move(stream)));
+			}
+		}
+	}
+}
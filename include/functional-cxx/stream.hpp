@@ -21,8 +21,10 @@
 
 #include <boost/variant.hpp>
 #include <boost/iterator/iterator_facade.hpp>
+#include <cstddef>
 #include <memory>
 #include <functional>
+#include <optional>
 #include <type_traits>
 #include <utility>
 
@@ -37,6 +39,25 @@ namespace com {
 		namespace functional {
 			using namespace detail;
 
+			template<class E> class Stream;
+
+			namespace detail {
+				/**************************************************
+				 * A pending `Stream` tail which a consumer may run
+				 * to completion without materializing its cells.
+				 * Nothing is memoized, so a stage is only drained
+				 * once no cell can reach it any more: see `forEach`.
+				 **************************************************/
+				template<class E>
+				struct StreamStage : Introspectable {
+					/// Feed every element of the tail this stage would produce to `sink`, consuming the stage.
+					virtual void drain(FunctionRef<void(const E&)> sink) = 0;
+				};
+				
+				template<class E, class Sink>
+				void drainStream(std::shared_ptr<Stream<E>> && cell, Sink && sink);
+			}
+
 			/**************************************************
 			 * Implements a `Stream` or "lazy list".
 			 * 
@@ -106,7 +127,9 @@ namespace com {
 			template<class E>
 			class Stream : public std::enable_shared_from_this<Stream<E>> {
 				template<class> friend class Stream;
+				template<class> friend class LazyTree;
 				template<class InStream, class Transform> friend class MapF;
+				template<class T, class Sink> friend void detail::drainStream(std::shared_ptr<Stream<T>> &&, Sink &&);
 				using StreamT = std::shared_ptr<Stream<E>>; ///< We consider a "true" stream to be a `std::shared_ptr<Stream>`
 				using F = detail::UniqueFunction<StreamT()>; ///< A functor returning new nodes
 				using std::enable_shared_from_this<Stream<E>>::shared_from_this;
@@ -139,6 +162,7 @@ namespace com {
 					
 					return std::make_shared<EnableMakeShared>(std::forward<A1>(a1), std::forward<A2>(a2));
 				}
+				
 			public:
 				/******************************************************
 				 *  Boiler-plate linked-list iterator implementation using 
@@ -206,6 +230,39 @@ namespace com {
 					return makeShared(std::forward<A1>(e), std::forward<A2>(t));
 				}
 				
+				/*****************************************************************
+				 * Create a new `Stream::StreamT` whose elements are produced
+				 * by successive calls to `generator`.
+				 * @arg generator is a (possibly move-only) functor returning
+				 * an optional-like value (e.g. `std::optional<E>`), which is
+				 * empty once the `Stream` is exhausted.
+				 * 
+				 * The first element is produced immediately, and each subsequent
+				 * element is produced when the preceding `Stream::tail` is forced,
+				 * so `generator` is invoked exactly once per element.
+				 *****************************************************************/
+				template<class Generator>
+				static StreamT Generate(Generator && generator) {
+					class GenerateF {
+						std::decay_t<Generator> generator_;
+						
+					public:
+						
+						GenerateF(std::decay_t<Generator> && generator)
+						: generator_(std::move(generator)) {}
+						
+						StreamT operator()() {
+							auto next = generator_();
+							if (next) {
+								return Cell(std::move(*next), GenerateF(std::move(generator_)));
+							} else {
+								return Nil();
+							}
+						}
+					};
+					return GenerateF(std::decay_t<Generator>(std::forward<Generator>(generator)))();
+				}
+				
 				/// Obtain an iterator to the beginning of the `Stream`.
 				StreamIterator begin() {
 					return StreamIterator(shared_from_this());
@@ -229,31 +286,183 @@ namespace com {
 				/*********************************************************************
 				 * Obtain a new `Stream` by applying `transform` to every element in this
 				 * `Stream`.
+				 * 
+				 * `transform` is applied once per element: `forEach`, `fold` and
+				 * `count` only skip allocating the mapped cells when they hold
+				 * the last reference to them, so those cells can never be forced.
 				 *********************************************************************/
 				template<class Transform>
 				MapStreamT<Transform> map(Transform && transform) {
-					class MapF {
-						std::function<StreamT()> src_;
-						Transform transform_;
+					using R = std::invoke_result_t<Transform,E>;
+					/*********************************************************************
+					 * Each pending tail of a mapped `Stream` remembers the cell of
+					 * this `Stream` it is positioned after, so that `drain` can
+					 * hand it on to be walked (or itself drained) directly.
+					 *********************************************************************/
+					class MapF final : public detail::StreamStage<R> {
+						StreamT prev_;
+						std::decay_t<Transform> transform_;
 						
 					public:
 						
-						MapF(const std::function<StreamT()>& src, Transform&& transform)
-						: src_(src), transform_(std::forward<Transform>(transform)) {}
+						MapF(const StreamT& prev, std::decay_t<Transform>&& transform)
+						: prev_(prev), transform_(std::move(transform)) {}
 						
 						MapStreamT<Transform> operator()() {
-							auto src = src_();
+							auto src = prev_->tail();
 							if (src) {
 								auto transformed_head = transform_(src->head());
-								return MapCellT<Transform>::Cell(std::move(transformed_head), MapF([src](){ return src->tail(); }, std::move(transform_)));
+								return MapCellT<Transform>::Cell(std::move(transformed_head), MapF(src, std::move(transform_)));
 							} else {
 								return MapCellT<Transform>::Nil();
 							}
 						}
+						
+						void drain(FunctionRef<void(const R&)> sink) override {
+							detail::drainStream(std::move(prev_), [&](const E& e){
+								sink(transform_(e));
+							});
+						}
+					};
+					std::decay_t<Transform> t(std::forward<Transform>(transform));
+					auto transformed_head = t(head());
+					return MapCellT<Transform>::Cell(std::move(transformed_head), MapF(shared_from_this(), std::move(t)));
+				}
+				
+				/*********************************************************************
+				 * Obtain the longest prefix of this `Stream` whose elements all
+				 * satisfy `predicate`.
+				 * Each `Stream::tail` force of the result forces exactly one
+				 * `Stream::tail` of this `Stream`, and none are forced beyond
+				 * the first element which fails `predicate`.
+				 *********************************************************************/
+				template<class Predicate>
+				StreamT takeWhile(Predicate && predicate) {
+					class TakeWhileF {
+						StreamT src_;
+						std::decay_t<Predicate> predicate_;
+						
+					public:
+						
+						TakeWhileF(const StreamT& src, std::decay_t<Predicate>&& predicate)
+						: src_(src), predicate_(std::move(predicate)) {}
+						
+						StreamT operator()() {
+							auto next = src_->tail();
+							if (next && predicate_(next->head())) {
+								return Cell(next->head(), TakeWhileF(next, std::move(predicate_)));
+							} else {
+								return Nil();
+							}
+						}
 					};
-					return MapF([sharedThis = shared_from_this()](){ return sharedThis; }, std::forward<Transform>(transform))();
+					if (!predicate(head())) {
+						return Nil();
+					}
+					return Cell(head(), TakeWhileF(shared_from_this(), std::decay_t<Predicate>(std::forward<Predicate>(predicate))));
+				}
+				
+				/*********************************************************************
+				 * Obtain the first cell of this `Stream` whose `Stream::head`
+				 * satisfies `predicate`, or `Stream::Nil()` if there is none.
+				 * The search is iterative, and forces no further than the match.
+				 * @warning If no element matches, an unbounded `Stream` will
+				 * be searched forever.
+				 *********************************************************************/
+				template<class Predicate>
+				StreamT find(Predicate && predicate) {
+					StreamT cursor = shared_from_this();
+					while (cursor && !predicate(cursor->head())) {
+						cursor = cursor->tail();
+					}
+					return cursor;
 				}
 			};
+
+			namespace detail {
+				/*********************************************************************
+				 * Feed every element after `cell` to `sink`, releasing cells as we
+				 * go. Memoized cells are walked as usual, and so is a pending tail
+				 * that is still reachable from elsewhere; but once we hold the only
+				 * reference to a cell whose pending tail is a `detail::StreamStage`
+				 * (e.g. from `Stream::map`), that stage is drained directly and
+				 * its cells are never allocated.
+				 *********************************************************************/
+				template<class E, class Sink>
+				void drainStream(std::shared_ptr<Stream<E>> && cell, Sink && sink) {
+					using F = typename Stream<E>::F;
+					while(cell) {
+						if(cell->tail_.which() && cell.use_count() == 1) {
+							if(auto stage = boost::get<F>(cell->tail_).template target<StreamStage<E>>()) {
+								F pending = std::move(boost::get<F>(cell->tail_));
+								cell.reset();
+								stage->drain(sink);
+								return;
+							}
+						}
+						auto next = cell->tail();
+						if(next) {
+							sink(next->head());
+						}
+						cell = std::move(next);
+					}
+				}
+			}
+			
+			/*********************************************************************
+			 * Invoke `f` on every element of `stream`.
+			 * 
+			 * Cells are released as we go, so when `stream` is the only reference
+			 * to them this runs in constant memory, and pending `Stream::map`
+			 * stages are fused into this loop: the mapped cells are never
+			 * allocated, and the transforms are applied directly to the source
+			 * elements. Cells still reachable from elsewhere are forced and
+			 * memoized as usual, so no transform is ever applied twice.
+			 * @warning An unbounded `Stream` will be consumed forever.
+			 *********************************************************************/
+			template<class E, class Visitor>
+			void forEach(std::shared_ptr<Stream<E>> && stream, Visitor && f) {
+				if(stream) {
+					f(stream->head());
+					detail::drainStream(std::move(stream), [&](const E& e){
+						f(e);
+					});
+				}
+			}
+			
+			/// Left fold over `stream`: `op(op(op(init, e0), e1), ...)`. Consumes and fuses as `forEach`.
+			template<class E, class A, class Op>
+			A fold(std::shared_ptr<Stream<E>> && stream, A init, Op && op) {
+				forEach(std::move(stream), [&](const E& e){
+					init = op(std::move(init), e);
+				});
+				return init;
+			}
+			
+			/// The number of elements in `stream`. Consumes and fuses as `forEach`.
+			template<class E>
+			std::size_t count(std::shared_ptr<Stream<E>> && stream) {
+				std::size_t n = 0;
+				forEach(std::move(stream), [&](const E&){
+					++n;
+				});
+				return n;
+			}
+
+			/*********************************************************************
+			 * The `Stream` following the first `n` elements of `stream`, or
+			 * `Stream::Nil()` if it has no more than `n`. The skipped cells
+			 * are forced, but released as we go, so when `stream` is the only
+			 * reference to them this runs in constant memory.
+			 *********************************************************************/
+			template<class E>
+			std::shared_ptr<Stream<E>> drop(std::shared_ptr<Stream<E>> stream, std::size_t n) {
+				for (; stream && n; --n) {
+					auto next = stream->tail();
+					stream = std::move(next);
+				}
+				return stream;
+			}
 		}
 	}
 }
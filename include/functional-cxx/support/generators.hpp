@@ -0,0 +1,228 @@
+#pragma once
+/************************************************************************************
+ *
+ * Author: Thomas Dickerson
+ * Copyright: 2021, Geopipe, Inc.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ************************************************************************************/
+
+#include <cstddef>
+#include <iterator>
+#include <optional>
+#include <type_traits>
+#include <utility>
+
+namespace com {
+	namespace geopipe {
+		/**************************************************
+		 * Tools for functional programming
+		 **************************************************/
+		namespace functional {
+			/**************************************************
+			 * Internal implementation details
+			 **************************************************/
+			namespace detail {
+				/**************************************************
+				 * A "generator" is a (possibly move-only) functor
+				 * returning `std::optional<E>`, which is empty once
+				 * it is exhausted; the same protocol as `Stream::Generate`.
+				 * The adaptors below compose generators without any
+				 * type erasure, so a pipeline of them inlines into
+				 * a single loop.
+				 **************************************************/
+				template<class Gen>
+				using GeneratedT = typename std::invoke_result_t<Gen&>::value_type;
+
+				/// Yields `transform(e)` for each `e` yielded by `Src`.
+				template<class Src, class Transform>
+				class MapGen {
+					Src src_;
+					Transform transform_;
+				public:
+					using value_type = std::decay_t<std::invoke_result_t<Transform&, GeneratedT<Src>&&>>;
+
+					MapGen(Src && src, Transform && transform)
+					: src_(std::move(src)), transform_(std::move(transform)) {}
+
+					std::optional<value_type> operator()() {
+						if(auto e = src_()) {
+							return std::optional<value_type>(transform_(std::move(*e)));
+						}
+						return std::nullopt;
+					}
+				};
+
+				/// Yields only the elements of `Src` which satisfy `Predicate`.
+				template<class Src, class Predicate>
+				class FilterGen {
+					Src src_;
+					Predicate predicate_;
+				public:
+					FilterGen(Src && src, Predicate && predicate)
+					: src_(std::move(src)), predicate_(std::move(predicate)) {}
+
+					std::optional<GeneratedT<Src>> operator()() {
+						while(auto e = src_()) {
+							if(predicate_(std::as_const(*e))) {
+								return e;
+							}
+						}
+						return std::nullopt;
+					}
+				};
+
+				/// Yields at most `n` elements of `Src`, and never invokes it once they have been taken.
+				template<class Src>
+				class TakeGen {
+					Src src_;
+					std::size_t remaining_;
+				public:
+					TakeGen(Src && src, std::size_t n)
+					: src_(std::move(src)), remaining_(n) {}
+
+					std::optional<GeneratedT<Src>> operator()() {
+						if(!remaining_) {
+							return std::nullopt;
+						}
+						--remaining_;
+						return src_();
+					}
+				};
+
+				/// Yields elements of `Src` while they satisfy `Predicate`, and never invokes it after the first which does not.
+				template<class Src, class Predicate>
+				class TakeWhileGen {
+					Src src_;
+					Predicate predicate_;
+					bool done_;
+				public:
+					TakeWhileGen(Src && src, Predicate && predicate)
+					: src_(std::move(src)), predicate_(std::move(predicate)), done_(false) {}
+
+					std::optional<GeneratedT<Src>> operator()() {
+						if(!done_) {
+							if(auto e = src_()) {
+								if(predicate_(std::as_const(*e))) {
+									return e;
+								}
+							}
+							done_ = true;
+						}
+						return std::nullopt;
+					}
+				};
+
+				/// Yields `step(state)` until it is empty, mutating one `state` in place.
+				template<class S, class Step>
+				class UnfoldGen {
+					S state_;
+					Step step_;
+				public:
+					using value_type = typename std::invoke_result_t<Step&, S&>::value_type;
+
+					UnfoldGen(S && state, Step && step)
+					: state_(std::move(state)), step_(std::move(step)) {}
+
+					std::optional<value_type> operator()() {
+						return step_(state_);
+					}
+				};
+
+				/// Yields `seed`, `f(seed)`, `f(f(seed))`, ... forever.
+				template<class E, class F>
+				class IterateGen {
+					E current_;
+					F f_;
+					bool started_;
+				public:
+					IterateGen(E && seed, F && f)
+					: current_(std::move(seed)), f_(std::move(f)), started_(false) {}
+
+					std::optional<E> operator()() {
+						if(started_) {
+							current_ = f_(std::as_const(current_));
+						}
+						started_ = true;
+						return current_;
+					}
+				};
+
+				/**************************************************
+				 * Yields copies of the elements of a `Stream`.
+				 * Only the current cell is retained, so cells behind
+				 * it are reclaimed as we go, unless retained elsewhere.
+				 **************************************************/
+				template<class StreamPtr>
+				class StreamGen {
+					StreamPtr cell_;
+					bool started_;
+				public:
+					using value_type = std::decay_t<decltype(std::declval<StreamPtr&>()->head())>;
+
+					explicit StreamGen(StreamPtr && cell)
+					: cell_(std::move(cell)), started_(false) {}
+
+					std::optional<value_type> operator()() {
+						if(started_ && cell_) {
+							// Copy before assigning, since the old cell may own its tail.
+							StreamPtr next = cell_->tail();
+							cell_ = std::move(next);
+						}
+						started_ = true;
+						if(!cell_) {
+							return std::nullopt;
+						}
+						return std::optional<value_type>(cell_->head());
+					}
+				};
+
+				/**************************************************
+				 * Invoke `f` on each element of the `Stream` starting at
+				 * `cell`, retaining only the current cell as `StreamGen`
+				 * does, so a sink handed the only reference to a `Stream`
+				 * runs in constant memory.
+				 **************************************************/
+				template<class StreamPtr, class F>
+				void consumeStream(StreamPtr cell, F && f) {
+					while(cell) {
+						f(cell->head());
+						StreamPtr next = cell->tail();
+						cell = std::move(next);
+					}
+				}
+
+				/// Yields copies of the elements of `[first, last)`.
+				template<class It, class Sentinel = It>
+				class IteratorGen {
+					It first_;
+					Sentinel last_;
+				public:
+					using value_type = typename std::iterator_traits<It>::value_type;
+
+					IteratorGen(It first, Sentinel last)
+					: first_(std::move(first)), last_(std::move(last)) {}
+
+					std::optional<value_type> operator()() {
+						if(first_ == last_) {
+							return std::nullopt;
+						}
+						return std::optional<value_type>(*first_++);
+					}
+				};
+			}
+		}
+	}
+}
@@ -0,0 +1,100 @@
+#pragma once
+/************************************************************************************
+ *
+ * Author: Thomas Dickerson
+ * Copyright: 2021, Geopipe, Inc.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ************************************************************************************/
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <tuple>
+#include <utility>
+
+namespace com {
+	namespace geopipe {
+		/**************************************************
+		 * Tools for functional programming
+		 **************************************************/
+		namespace functional {
+			/**************************************************
+			 * Internal implementation details
+			 **************************************************/
+			namespace detail {
+				/**************************************************
+				 * The 64-bit finalizer from MurmurHash3.
+				 * `std::hash` is the identity for integers on common
+				 * implementations, which is disastrous for linear
+				 * probing and for sketches that consume hash bits,
+				 * so we always pass its output through this.
+				 **************************************************/
+				constexpr std::uint64_t mix64(std::uint64_t h) {
+					h ^= h >> 33;
+					h *= 0xff51afd7ed558ccdULL;
+					h ^= h >> 33;
+					h *= 0xc4ceb9fe1a85ec53ULL;
+					h ^= h >> 33;
+					return h;
+				}
+
+				/// The number of leading zero bits in `x`, which is 64 if `x` is zero.
+				inline unsigned countLeadingZeros64(std::uint64_t x) {
+#if defined(__GNUC__) || defined(__clang__)
+					return x ? unsigned(__builtin_clzll(x)) : 64;
+#else
+					unsigned n = 0;
+					for(std::uint64_t bit = std::uint64_t(1) << 63; bit && !(x & bit); bit >>= 1) {
+						++n;
+					}
+					return n;
+#endif
+				}
+
+				/// Combine `h` into the running hash `seed`, boost-style but with 64-bit constants.
+				constexpr std::uint64_t hashCombine(std::uint64_t seed, std::uint64_t h) {
+					return seed ^ (h + 0x9e3779b97f4a7c15ULL + (seed << 6) + (seed >> 2));
+				}
+
+				/// `std::hash`, extended to pairs and tuples, with well-mixed output bits.
+				template<class T>
+				struct Hash {
+					std::uint64_t operator()(const T& t) const {
+						return mix64(std::hash<T>()(t));
+					}
+				};
+
+				template<class... Ts>
+				struct Hash<std::tuple<Ts...>> {
+					std::uint64_t operator()(const std::tuple<Ts...>& t) const {
+						return mix64(std::apply([](const Ts& ...ts){
+							std::uint64_t seed = 0;
+							((seed = hashCombine(seed, Hash<Ts>()(ts))), ...);
+							return seed;
+						}, t));
+					}
+				};
+
+				template<class A, class B>
+				struct Hash<std::pair<A, B>> {
+					std::uint64_t operator()(const std::pair<A, B>& p) const {
+						return mix64(hashCombine(Hash<A>()(p.first), Hash<B>()(p.second)));
+					}
+				};
+			}
+		}
+	}
+}
@@ -0,0 +1,194 @@
+#pragma once
+/************************************************************************************
+ *
+ * Author: Thomas Dickerson
+ * Copyright: 2021, Geopipe, Inc.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ************************************************************************************/
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdlib>
+#include <functional>
+#include <limits>
+#include <memory>
+#include <new>
+#include <utility>
+#include <vector>
+
+namespace com {
+	namespace geopipe {
+		/**************************************************
+		 * Tools for functional programming
+		 **************************************************/
+		namespace functional {
+			/**************************************************
+			 * Internal implementation details
+			 **************************************************/
+			namespace detail {
+				/// A `std::unique_ptr` deleter for memory obtained from `std::calloc`.
+				struct FreeDeleter {
+					void operator()(void *p) const {
+						std::free(p);
+					}
+				};
+
+				/**************************************************
+				 * A `D`-ary min-heap over the dense ids `[0, n)`,
+				 * supporting decrease-key.
+				 *
+				 * Keys are stored inline with the ids in the heap array,
+				 * so sifting never leaves it. The id-to-position index is
+				 * obtained from `std::calloc`, so for large `n` the OS hands
+				 * out zeroed pages lazily, and a search which only touches
+				 * a small region of the id space only pays for that region.
+				 *
+				 * Each id moves through three states: unseen, queued,
+				 * and popped. Popped ids may not be pushed again.
+				 **************************************************/
+				template<class Key, class Compare = std::less<Key>, std::size_t D = 4>
+				class IndexedDaryHeap {
+					static_assert(D >= 2, "A heap must have arity of at least 2");
+					static constexpr std::size_t kUnseen = 0;
+					static constexpr std::size_t kPopped = std::numeric_limits<std::size_t>::max();
+
+					struct Entry {
+						Key key;
+						std::size_t id;
+					};
+
+					std::vector<Entry> heap_;
+					std::unique_ptr<std::size_t[], FreeDeleter> slots_; ///< `kUnseen`, `kPopped`, or heap position + 1.
+					Compare cmp_;
+
+					void place(std::size_t pos, Entry && e) {
+						slots_[e.id] = pos + 1;
+						heap_[pos] = std::move(e);
+					}
+
+					void siftUp(std::size_t pos) {
+						Entry e = std::move(heap_[pos]);
+						while(pos > 0) {
+							std::size_t parent = (pos - 1) / D;
+							if(!cmp_(e.key, heap_[parent].key)) {
+								break;
+							}
+							place(pos, std::move(heap_[parent]));
+							pos = parent;
+						}
+						place(pos, std::move(e));
+					}
+
+					void siftDown(std::size_t pos) {
+						Entry e = std::move(heap_[pos]);
+						std::size_t n = heap_.size();
+						for(;;) {
+							std::size_t first = pos * D + 1;
+							if(first >= n) {
+								break;
+							}
+							std::size_t last = std::min(first + D, n);
+							std::size_t best = first;
+							for(std::size_t c = first + 1; c < last; ++c) {
+								if(cmp_(heap_[c].key, heap_[best].key)) {
+									best = c;
+								}
+							}
+							if(!cmp_(heap_[best].key, e.key)) {
+								break;
+							}
+							place(pos, std::move(heap_[best]));
+							pos = best;
+						}
+						place(pos, std::move(e));
+					}
+				public:
+					explicit IndexedDaryHeap(std::size_t n, Compare cmp = Compare())
+					: slots_(static_cast<std::size_t*>(std::calloc(n ? n : 1, sizeof(std::size_t)))), cmp_(std::move(cmp)) {
+						if(!slots_) {
+							throw std::bad_alloc();
+						}
+					}
+
+					bool empty() const {
+						return heap_.empty();
+					}
+
+					std::size_t size() const {
+						return heap_.size();
+					}
+
+					bool seen(std::size_t id) const {
+						return slots_[id] != kUnseen;
+					}
+
+					bool queued(std::size_t id) const {
+						return slots_[id] != kUnseen && slots_[id] != kPopped;
+					}
+
+					bool popped(std::size_t id) const {
+						return slots_[id] == kPopped;
+					}
+
+					/// @pre `queued(id)`
+					const Key& key(std::size_t id) const {
+						return heap_[slots_[id] - 1].key;
+					}
+
+					/**************************************************
+					 * Insert `id` with `key`, or lower its key if it is
+					 * already queued and `key` is an improvement.
+					 * Returns `true` if the heap changed.
+					 * @pre `!popped(id)`
+					 **************************************************/
+					bool pushOrDecrease(std::size_t id, Key key) {
+						if(slots_[id] == kUnseen) {
+							heap_.push_back(Entry{std::move(key), id});
+							siftUp(heap_.size() - 1);
+							return true;
+						}
+						std::size_t pos = slots_[id] - 1;
+						if(cmp_(key, heap_[pos].key)) {
+							heap_[pos].key = std::move(key);
+							siftUp(pos);
+							return true;
+						}
+						return false;
+					}
+
+					/// The id with the least key, and that key.
+					std::pair<std::size_t, const Key&> top() const {
+						return {heap_.front().id, heap_.front().key};
+					}
+
+					/// Remove and return the id with the least key, and that key.
+					std::pair<std::size_t, Key> pop() {
+						Entry result = std::move(heap_.front());
+						slots_[result.id] = kPopped;
+						if(heap_.size() > 1) {
+							heap_.front() = std::move(heap_.back());
+							heap_.pop_back();
+							siftDown(0);
+						} else {
+							heap_.pop_back();
+						}
+						return {result.id, std::move(result.key)};
+					}
+				};
+			}
+		}
+	}
+}
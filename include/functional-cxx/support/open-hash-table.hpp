@@ -0,0 +1,338 @@
+#pragma once
+/************************************************************************************
+ *
+ * Author: Thomas Dickerson
+ * Copyright: 2021, Geopipe, Inc.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ************************************************************************************/
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <new>
+#include <utility>
+
+#include <functional-cxx/support/hashing.hpp>
+#include <functional-cxx/support/memory-hacks.hpp>
+
+namespace com {
+	namespace geopipe {
+		/**************************************************
+		 * Tools for functional programming
+		 **************************************************/
+		namespace functional {
+			/**************************************************
+			 * Internal implementation details
+			 **************************************************/
+			namespace detail {
+				/// Value type for using `OpenHashMap` as a set.
+				struct Unit {};
+
+				/**************************************************
+				 * A linear-probing hash map with power-of-two capacity.
+				 *
+				 * Entries live inline in one flat array (plus a byte of
+				 * occupancy per slot), so a lookup is usually a single
+				 * cache miss. Deletion uses backward-shift rather than
+				 * tombstones, so the table never degrades under churn.
+				 *
+				 * Lookups are heterogeneous: `find`, `erase` and friends
+				 * accept any `Q` for which `H` and `Eq` are callable, which
+				 * lets callers store compact keys (e.g. indices into an
+				 * arena) while probing with the full value.
+				 *
+				 * Pointers to values are invalidated by any insertion
+				 * or erasure.
+				 **************************************************/
+				template<class K, class V, class H = Hash<K>, class Eq = std::equal_to<>>
+				class OpenHashMap {
+					struct Slot {
+						K key;
+						V value;
+					};
+
+					std::unique_ptr<AlignedFor<Slot>[]> slots_;
+					std::unique_ptr<std::uint8_t[]> used_;
+					std::size_t mask_;
+					std::size_t size_;
+					H hash_;
+					Eq eq_;
+
+					Slot& slot(std::size_t i) {
+						return *std::launder(reinterpret_cast<Slot*>(&slots_[i]));
+					}
+
+					const Slot& slot(std::size_t i) const {
+						return *std::launder(reinterpret_cast<const Slot*>(&slots_[i]));
+					}
+
+					template<class Q>
+					std::size_t home(const Q& q) const {
+						return std::size_t(hash_(q)) & mask_;
+					}
+
+					/// Index of the slot holding `q`, or of the empty slot where it would go.
+					template<class Q>
+					std::size_t probe(const Q& q) const {
+						std::size_t i = home(q);
+						while(used_[i] && !eq_(slot(i).key, q)) {
+							i = (i + 1) & mask_;
+						}
+						return i;
+					}
+
+					void allocate(std::size_t capacity) {
+						slots_.reset(new AlignedFor<Slot>[capacity]);
+						used_.reset(new std::uint8_t[capacity]());
+						mask_ = capacity - 1;
+					}
+
+					void rehash(std::size_t capacity) {
+						auto oldSlots = std::move(slots_);
+						auto oldUsed = std::move(used_);
+						std::size_t oldCapacity = mask_ + 1;
+						allocate(capacity);
+						for(std::size_t i = 0; i < oldCapacity; ++i) {
+							if(oldUsed[i]) {
+								Slot& s = *std::launder(reinterpret_cast<Slot*>(&oldSlots[i]));
+								std::size_t j = probe(s.key);
+								new (&slots_[j]) Slot(std::move(s));
+								used_[j] = 1;
+								s.~Slot();
+							}
+						}
+					}
+
+					static std::size_t roundUpPow2(std::size_t n) {
+						std::size_t result = 8;
+						while(result < n) {
+							result <<= 1;
+						}
+						return result;
+					}
+				public:
+					explicit OpenHashMap(std::size_t initialCapacity = 16, H hash = H(), Eq eq = Eq())
+					: mask_(0), size_(0), hash_(std::move(hash)), eq_(std::move(eq)) {
+						allocate(roundUpPow2(initialCapacity));
+					}
+
+					OpenHashMap(const OpenHashMap&) = delete;
+					OpenHashMap& operator=(const OpenHashMap&) = delete;
+
+					OpenHashMap(OpenHashMap && other) noexcept
+					: slots_(std::move(other.slots_)), used_(std::move(other.used_)), mask_(other.mask_), size_(other.size_),
+					  hash_(std::move(other.hash_)), eq_(std::move(other.eq_)) {
+						other.size_ = 0;
+					}
+
+					OpenHashMap& operator=(OpenHashMap && other) noexcept {
+						if(this != &other) {
+							clear();
+							slots_ = std::move(other.slots_);
+							used_ = std::move(other.used_);
+							mask_ = other.mask_;
+							size_ = other.size_;
+							hash_ = std::move(other.hash_);
+							eq_ = std::move(other.eq_);
+							other.size_ = 0;
+						}
+						return *this;
+					}
+
+					~OpenHashMap() {
+						clear();
+					}
+
+					std::size_t size() const {
+						return size_;
+					}
+
+					bool empty() const {
+						return size_ == 0;
+					}
+
+					/// Ensure `n` entries fit without rehashing.
+					void reserve(std::size_t n) {
+						std::size_t wanted = roundUpPow2(n + n / 3 + 1);
+						if(wanted > mask_ + 1) {
+							rehash(wanted);
+						}
+					}
+
+					template<class Q>
+					V* find(const Q& q) {
+						std::size_t i = probe(q);
+						return used_[i] ? &slot(i).value : nullptr;
+					}
+
+					template<class Q>
+					const V* find(const Q& q) const {
+						std::size_t i = probe(q);
+						return used_[i] ? &slot(i).value : nullptr;
+					}
+
+					/// The stored key equal to `q`, if any.
+					template<class Q>
+					const K* findKey(const Q& q) const {
+						std::size_t i = probe(q);
+						return used_[i] ? &slot(i).key : nullptr;
+					}
+
+					/**************************************************
+					 * Insert `key` with a value constructed from `args`,
+					 * unless it is already present.
+					 * Returns the value for `key`, and whether it was inserted.
+					 **************************************************/
+					template<class KA, class ...Args>
+					std::pair<V*, bool> tryEmplace(KA && key, Args && ...args) {
+						std::size_t i = probe(key);
+						if(used_[i]) {
+							return {&slot(i).value, false};
+						}
+						// Keep the load factor at or below 3/4.
+						if(4 * (size_ + 1) > 3 * (mask_ + 1)) {
+							rehash(2 * (mask_ + 1));
+							i = probe(key);
+						}
+						new (&slots_[i]) Slot{K(std::forward<KA>(key)), V(std::forward<Args>(args)...)};
+						used_[i] = 1;
+						++size_;
+						return {&slot(i).value, true};
+					}
+
+					template<class Q>
+					bool erase(const Q& q) {
+						std::size_t i = probe(q);
+						if(!used_[i]) {
+							return false;
+						}
+						eraseAt(i);
+						return true;
+					}
+
+					void clear() {
+						if(used_) {
+							for(std::size_t i = 0; i <= mask_ && size_; ++i) {
+								if(used_[i]) {
+									slot(i).~Slot();
+									used_[i] = 0;
+									--size_;
+								}
+							}
+						}
+						size_ = 0;
+					}
+
+					/**************************************************
+					 * Slot-level access, for callers implementing their
+					 * own traversal or eviction policies.
+					 **************************************************/
+					std::size_t slotCount() const {
+						return mask_ + 1;
+					}
+
+					bool occupied(std::size_t i) const {
+						return used_[i];
+					}
+
+					const K& keyAt(std::size_t i) const {
+						return slot(i).key;
+					}
+
+					V& valueAt(std::size_t i) {
+						return slot(i).value;
+					}
+
+					/**************************************************
+					 * Remove the entry in slot `i` by backward-shift.
+					 * @warning A later entry may be moved into slot `i`,
+					 * so a caller sweeping over slots should re-examine it.
+					 **************************************************/
+					void eraseAt(std::size_t i) {
+						slot(i).~Slot();
+						used_[i] = 0;
+						--size_;
+						for(std::size_t j = (i + 1) & mask_; used_[j]; j = (j + 1) & mask_) {
+							std::size_t k = home(slot(j).key);
+							// Shift `j` back into the hole unless its home lies cyclically in `(i, j]`.
+							bool stays = (i <= j) ? (i < k && k <= j) : (i < k || k <= j);
+							if(!stays) {
+								new (&slots_[i]) Slot(std::move(slot(j)));
+								used_[i] = 1;
+								slot(j).~Slot();
+								used_[j] = 0;
+								i = j;
+							}
+						}
+					}
+
+					/// Visit every entry as `f(key, value)`.
+					template<class F>
+					void forEach(F && f) {
+						for(std::size_t i = 0; i <= mask_; ++i) {
+							if(used_[i]) {
+								f(slot(i).key, slot(i).value);
+							}
+						}
+					}
+
+					template<class F>
+					void forEach(F && f) const {
+						for(std::size_t i = 0; i <= mask_; ++i) {
+							if(used_[i]) {
+								f(slot(i).key, slot(i).value);
+							}
+						}
+					}
+				};
+
+				/// A linear-probing hash set. See `OpenHashMap`.
+				template<class K, class H = Hash<K>, class Eq = std::equal_to<>>
+				class OpenHashSet {
+					OpenHashMap<K, Unit, H, Eq> map_;
+				public:
+					explicit OpenHashSet(std::size_t initialCapacity = 16, H hash = H(), Eq eq = Eq())
+					: map_(initialCapacity, std::move(hash), std::move(eq)) {}
+
+					std::size_t size() const {
+						return map_.size();
+					}
+
+					/// Returns `true` if `key` was not already present.
+					template<class KA>
+					bool insert(KA && key) {
+						return map_.tryEmplace(std::forward<KA>(key)).second;
+					}
+
+					template<class Q>
+					bool contains(const Q& q) const {
+						return map_.find(q) != nullptr;
+					}
+
+					template<class Q>
+					bool erase(const Q& q) {
+						return map_.erase(q);
+					}
+
+					void clear() {
+						map_.clear();
+					}
+				};
+			}
+		}
+	}
+}
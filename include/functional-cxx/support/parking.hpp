@@ -0,0 +1,100 @@
+#pragma once
+/************************************************************************************
+ *
+ * Author: Thomas Dickerson
+ * Copyright: 2021, Geopipe, Inc.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ************************************************************************************/
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <mutex>
+
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+#include <immintrin.h>
+#endif
+
+namespace com {
+	namespace geopipe {
+		/**************************************************
+		 * Tools for functional programming
+		 **************************************************/
+		namespace functional {
+			/**************************************************
+			 * Internal implementation details
+			 **************************************************/
+			namespace detail {
+				/// Padding granularity used to keep independently-written atomics off each other's cache lines.
+				constexpr std::size_t kCacheLineSize = 64;
+
+				/// Hint to the CPU that we are in a spin-wait loop.
+				inline void cpuRelax() {
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+					_mm_pause();
+#endif
+				}
+
+				/**************************************************
+				 * A spin-then-park wait primitive for lock-free queues.
+				 *
+				 * Waiters spin for a while polling a readiness predicate,
+				 * and only fall back to a `std::condition_variable` if it
+				 * stays false. Notifiers only touch the mutex if somebody
+				 * is actually parked, so the uncontended fast path is a
+				 * fence and a relaxed load.
+				 *
+				 * The predicate must read state which the notifier published
+				 * _before_ calling `Parker::notify`.
+				 **************************************************/
+				class Parker {
+					std::mutex mutex_;
+					std::condition_variable cv_;
+					std::atomic<std::size_t> parked_;
+				public:
+					Parker() : parked_(0) {}
+					Parker(const Parker&) = delete;
+					Parker& operator=(const Parker&) = delete;
+
+					template<class Ready>
+					void wait(Ready && ready, std::size_t spins) {
+						for(std::size_t i = 0; i < spins; ++i) {
+							if(ready()) {
+								return;
+							}
+							cpuRelax();
+						}
+						std::unique_lock<std::mutex> lock(mutex_);
+						parked_.fetch_add(1, std::memory_order_relaxed);
+						// Pairs with the fence in `notify`: either we observe the published state,
+						// or the notifier observes that we are parked.
+						std::atomic_thread_fence(std::memory_order_seq_cst);
+						cv_.wait(lock, ready);
+						parked_.fetch_sub(1, std::memory_order_relaxed);
+					}
+
+					void notify() {
+						std::atomic_thread_fence(std::memory_order_seq_cst);
+						if(parked_.load(std::memory_order_relaxed)) {
+							std::lock_guard<std::mutex> lock(mutex_);
+							cv_.notify_all();
+						}
+					}
+				};
+			}
+		}
+	}
+}
@@ -0,0 +1,120 @@
+#pragma once
+/************************************************************************************
+ *
+ * Author: Thomas Dickerson
+ * Copyright: 2021, Geopipe, Inc.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ************************************************************************************/
+
+#include <atomic>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <istream>
+#include <optional>
+#include <ostream>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <type_traits>
+
+namespace com {
+	namespace geopipe {
+		/**************************************************
+		 * Tools for functional programming
+		 **************************************************/
+		namespace functional {
+			/**************************************************
+			 * The default serializer for the combinators that spill
+			 * to disk (`externalSort`, `spillingStream`), which copies
+			 * the bytes of trivially copyable (and default constructible) types.
+			 *
+			 * A serializer for any other `E` is an object with
+			 * ~~~
+			 * void write(std::ostream& out, const E& e);
+			 * std::optional<E> read(std::istream& in); // Empty at a clean end of the file.
+			 * ~~~
+			 * where `read` throws `std::runtime_error` on a truncated
+			 * record or a failed read, rather than ending the data early.
+			 * which may be copied to each worker thread. Data is only
+			 * ever read back by the process which wrote it, so the
+			 * format need not be portable.
+			 **************************************************/
+			template<class E>
+			struct BinarySerializer {
+				static_assert(std::is_trivially_copyable_v<E> && std::is_default_constructible_v<E>, "BinarySerializer requires a trivially copyable, default constructible type: supply a serializer");
+
+				void write(std::ostream& out, const E& e) const {
+					out.write(reinterpret_cast<const char*>(&e), sizeof(E));
+				}
+
+				std::optional<E> read(std::istream& in) const {
+					E e;
+					if(!in.read(reinterpret_cast<char*>(&e), sizeof(E))) {
+						if(in.eof() && in.gcount() == 0) {
+							return std::nullopt;
+						}
+						throw std::runtime_error("BinarySerializer: truncated or failed read");
+					}
+					return e;
+				}
+			};
+
+			/**************************************************
+			 * Internal implementation details
+			 **************************************************/
+			namespace detail {
+				/**************************************************
+				 * A uniquely named temporary file in `directory`,
+				 * removed when this is destroyed. It is only a name:
+				 * open it with whatever streams are needed.
+				 **************************************************/
+				class SpillFile {
+					std::filesystem::path path_;
+				public:
+					SpillFile(const std::filesystem::path& directory, const char *prefix) {
+						static std::atomic<std::uint64_t> counter(0);
+						thread_local std::mt19937_64 rng(std::random_device{}());
+						std::error_code ec;
+						for(int attempt = 0; attempt < 16; ++attempt) {
+							path_ = directory / (std::string(prefix) + "-" + std::to_string(rng()) + "-" + std::to_string(counter++) + ".spill");
+							if(!std::filesystem::exists(path_, ec)) {
+								std::ofstream create(path_, std::ios::binary | std::ios::trunc);
+								if(create) {
+									return;
+								}
+							}
+						}
+						throw std::runtime_error("SpillFile: cannot create a temporary file in " + directory.string());
+					}
+
+					SpillFile(const SpillFile&) = delete;
+					SpillFile& operator=(const SpillFile&) = delete;
+
+					~SpillFile() {
+						std::error_code ec;
+						std::filesystem::remove(path_, ec);
+					}
+
+					const std::filesystem::path& path() const {
+						return path_;
+					}
+				};
+			}
+		}
+	}
+}
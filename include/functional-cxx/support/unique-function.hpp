@@ -21,6 +21,7 @@
 
 #include <memory>
 #include <functional>		// std::invoke
+#include <type_traits>
 #include <utility>
 
 namespace com {
@@ -33,6 +34,16 @@ namespace com {
 			 * Internal implementation details
 			 **************************************************/
 			namespace detail {
+				/**************************************************
+				 * Base class for functors which want to be recognizable
+				 * (via `UniqueFunction::target`) after type erasure,
+				 * e.g. so that a consumer can fuse a pending `Stream`
+				 * stage into its own loop instead of invoking it.
+				 **************************************************/
+				struct Introspectable {
+					virtual ~Introspectable() {}
+				};
+
 				template<typename T>
 				class UniqueFunction;
 				
@@ -49,6 +60,7 @@ namespace com {
 				class UniqueFunction<R(Args...)> {
 					struct FunctionHolderBase {
 						virtual R operator()(Args ...args) = 0;
+						virtual Introspectable* introspect() = 0;
 						virtual ~FunctionHolderBase() {}
 					};
 					template<typename F>
@@ -69,6 +81,14 @@ namespace com {
 						R operator()(Args&& ...args) override {
 							return std::invoke(f_, std::forward<Args>(args)...);
 						}
+
+						Introspectable* introspect() override {
+							if constexpr (std::is_base_of_v<Introspectable, F>) {
+								return &f_;
+							} else {
+								return nullptr;
+							}
+						}
 					};
 
 					std::unique_ptr<FunctionHolderBase> fh_;
@@ -91,6 +111,37 @@ namespace com {
 					explicit operator bool() const noexcept {
 						return (bool)fh_;
 					}
+
+					/// The wrapped functor, if it is an `Introspectable` of dynamic type `T`, otherwise `nullptr`.
+					template<typename T>
+					T* target() {
+						return fh_ ? dynamic_cast<T*>(fh_->introspect()) : nullptr;
+					}
+				};
+
+				template<typename T>
+				class FunctionRef;
+
+				/**************************************************
+				 * A non-owning, non-allocating reference to a callable,
+				 * for passing closures across virtual calls.
+				 * @warning The referenced callable must outlive the `FunctionRef`.
+				 **************************************************/
+				template<typename R, typename ...Args>
+				class FunctionRef<R(Args...)> {
+					void *f_;
+					R (*call_)(void*, Args...);
+				public:
+					template<typename F, typename = std::enable_if_t<!std::is_same_v<std::decay_t<F>, FunctionRef>>>
+					FunctionRef(F && f)
+					: f_(const_cast<void*>(static_cast<const void*>(std::addressof(f)))),
+					  call_([](void *f, Args ...args) -> R {
+						return std::invoke(*static_cast<std::remove_reference_t<F>*>(f), std::forward<Args>(args)...);
+					  }) {}
+
+					R operator()(Args ...args) const {
+						return call_(f_, std::forward<Args>(args)...);
+					}
 				};
 			}
 		}
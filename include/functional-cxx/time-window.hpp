@@ -0,0 +1,317 @@
+#pragma once
+/************************************************************************************
+ *
+ * Author: Thomas Dickerson
+ * Copyright: 2021, Geopipe, Inc.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ************************************************************************************/
+
+#include <cmath>
+#include <cstddef>
+#include <deque>
+#include <map>
+#include <memory>
+#include <optional>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include <functional-cxx/stream.hpp>
+#include <functional-cxx/support/generators.hpp>
+#include <functional-cxx/window.hpp>
+
+namespace com {
+	namespace geopipe {
+		/**************************************************
+		 * Tools for functional programming
+		 **************************************************/
+		namespace functional {
+			/// The result of one time-based window.
+			template<class Time, class T>
+			struct TimeWindow {
+				Time start; ///< Inclusive.
+				Time end; ///< Exclusive. For a session, the last event's time plus the gap.
+				T aggregate;
+				std::size_t count; ///< Number of events aggregated.
+				std::size_t lateDropped; ///< Events dropped as too late since the previous result.
+			};
+
+			/**************************************************
+			 * Internal implementation details
+			 **************************************************/
+			namespace detail {
+				/// The greatest multiple of `step` (counting from `Time()`) not after `t`.
+				template<class Time, class Duration>
+				Time alignDown(const Time& t, const Duration& step) {
+					auto offset = t - Time();
+					auto k = offset / step;
+					if constexpr (std::is_floating_point_v<decltype(k)>) {
+						k = std::floor(k);
+					} else if(offset < Duration() && !(k * step == offset)) {
+						--k;
+					}
+					return Time() + k * step;
+				}
+
+				/**************************************************
+				 * Common state for the time-window generators: the
+				 * watermark is the greatest event time seen, less the
+				 * allowed lateness, and windows are emitted (in order
+				 * of start time) once it passes their end.
+				 **************************************************/
+				template<class E, class TimeOf, class ValueOf, class Monoid>
+				class TimeWindowsBase {
+				protected:
+					using Time = std::decay_t<std::invoke_result_t<TimeOf&, const E&>>;
+					using Duration = decltype(std::declval<Time>() - std::declval<Time>());
+					using T = typename Monoid::value_type;
+					using Result = TimeWindow<Time, T>;
+
+					StreamGen<std::shared_ptr<Stream<E>>> input_;
+					TimeOf timeOf_;
+					ValueOf valueOf_;
+					Monoid monoid_;
+					Duration lateness_;
+					std::optional<Time> maxTime_;
+					std::size_t late_;
+					std::deque<Result> ready_;
+
+					TimeWindowsBase(std::shared_ptr<Stream<E>> && source, TimeOf && timeOf, ValueOf && valueOf, Monoid && monoid, Duration lateness)
+					: input_(std::move(source)), timeOf_(std::move(timeOf)), valueOf_(std::move(valueOf)), monoid_(std::move(monoid)), lateness_(lateness), late_(0) {}
+
+					/// Whether everything ending at or before `end` has been emitted.
+					bool closed(const Time& end) const {
+						return maxTime_ && !(*maxTime_ - lateness_ < end);
+					}
+
+					void observe(const Time& t) {
+						if(!maxTime_ || *maxTime_ < t) {
+							maxTime_ = t;
+						}
+					}
+
+					void emit(Time start, Time end, T && aggregate, std::size_t count) {
+						ready_.push_back(Result{std::move(start), std::move(end), std::move(aggregate), count, late_});
+						late_ = 0;
+					}
+
+					/// Drive `self.add` and `self.harvest` until a result is ready or the source is exhausted.
+					template<class Self>
+					std::optional<Result> pull(Self& self) {
+						while(ready_.empty()) {
+							auto e = input_();
+							if(!e) {
+								self.harvest(true);
+								break;
+							}
+							self.add(*e);
+							self.harvest(false);
+						}
+						if(ready_.empty()) {
+							return std::nullopt;
+						}
+						Result r = std::move(ready_.front());
+						ready_.pop_front();
+						return r;
+					}
+				};
+
+				/// Generator for `tumblingWindows` and `hoppingWindows`.
+				template<class E, class TimeOf, class ValueOf, class Monoid>
+				class AlignedWindowsF : TimeWindowsBase<E, TimeOf, ValueOf, Monoid> {
+					using Base = TimeWindowsBase<E, TimeOf, ValueOf, Monoid>;
+					using typename Base::Time;
+					using typename Base::Duration;
+					using typename Base::T;
+					using typename Base::Result;
+					friend Base;
+
+					struct Open {
+						T aggregate;
+						std::size_t count;
+					};
+
+					Duration size_;
+					Duration hop_;
+					std::map<Time, Open> open_; ///< Keyed by start time.
+
+					void add(const E& e) {
+						Time t = this->timeOf_(e);
+						Time latest = alignDown(t, hop_);
+						if(this->closed(latest + size_)) {
+							++this->late_;
+							return;
+						}
+						T value = this->valueOf_(e);
+						// Every window `[start, start + size)` containing `t`, from the latest back.
+						for(Time start = latest; t < start + size_ && !this->closed(start + size_); start = start - hop_) {
+							auto it = open_.try_emplace(start, Open{this->monoid_.identity, 0}).first;
+							it->second.aggregate = this->monoid_.combine(it->second.aggregate, value);
+							++it->second.count;
+						}
+						this->observe(t);
+					}
+
+					void harvest(bool all) {
+						while(!open_.empty() && (all || this->closed(open_.begin()->first + size_))) {
+							auto node = open_.extract(open_.begin());
+							this->emit(node.key(), node.key() + size_, std::move(node.mapped().aggregate), node.mapped().count);
+						}
+					}
+				public:
+					AlignedWindowsF(std::shared_ptr<Stream<E>> && source, TimeOf && timeOf, ValueOf && valueOf, Monoid && monoid, Duration size, Duration hop, Duration lateness)
+					: Base(std::move(source), std::move(timeOf), std::move(valueOf), std::move(monoid), lateness), size_(size), hop_(hop) {
+						if(!(Duration() < size) || !(Duration() < hop)) {
+							throw std::invalid_argument("hoppingWindows: the window size and hop must be positive");
+						}
+					}
+
+					std::optional<Result> operator()() {
+						return this->pull(*this);
+					}
+				};
+
+				/// Generator for `sessionWindows`.
+				template<class E, class TimeOf, class ValueOf, class Monoid>
+				class SessionWindowsF : TimeWindowsBase<E, TimeOf, ValueOf, Monoid> {
+					using Base = TimeWindowsBase<E, TimeOf, ValueOf, Monoid>;
+					using typename Base::Time;
+					using typename Base::Duration;
+					using typename Base::T;
+					using typename Base::Result;
+					friend Base;
+
+					struct Session {
+						Time last; ///< Time of the latest event.
+						T aggregate;
+						std::size_t count;
+					};
+
+					Duration gap_;
+					std::map<Time, Session> open_; ///< Keyed by start time. Sessions never overlap.
+
+					void add(const E& e) {
+						Time t = this->timeOf_(e);
+						// Sessions within `gap` of `t` are contiguous, ending just before the first to start at or after `t + gap`.
+						auto hi = open_.lower_bound(t + gap_);
+						auto lo = hi;
+						while(lo != open_.begin() && t < std::prev(lo)->second.last + gap_) {
+							--lo;
+						}
+						// Joining an open session extends it, so only an event which would start a session of its own can be late.
+						if(lo == hi && this->closed(t + gap_)) {
+							++this->late_;
+							return;
+						}
+						Time start = t;
+						Time last = t;
+						T aggregate = this->monoid_.identity;
+						std::size_t count = 1;
+						bool placed = false;
+						T value = this->valueOf_(e);
+						for(auto it = lo; it != hi; ++it) {
+							if(!placed && t < it->first) {
+								aggregate = this->monoid_.combine(aggregate, value);
+								placed = true;
+							}
+							aggregate = this->monoid_.combine(aggregate, it->second.aggregate);
+							count += it->second.count;
+							start = std::min(start, it->first);
+							last = std::max(last, it->second.last);
+						}
+						if(!placed) {
+							aggregate = this->monoid_.combine(aggregate, value);
+						}
+						open_.erase(lo, hi);
+						open_.emplace(start, Session{last, std::move(aggregate), count});
+						this->observe(t);
+					}
+
+					void harvest(bool all) {
+						while(!open_.empty() && (all || this->closed(open_.begin()->second.last + gap_))) {
+							auto node = open_.extract(open_.begin());
+							this->emit(node.key(), node.mapped().last + gap_, std::move(node.mapped().aggregate), node.mapped().count);
+						}
+					}
+				public:
+					SessionWindowsF(std::shared_ptr<Stream<E>> && source, TimeOf && timeOf, ValueOf && valueOf, Monoid && monoid, Duration gap, Duration lateness)
+					: Base(std::move(source), std::move(timeOf), std::move(valueOf), std::move(monoid), lateness), gap_(gap) {
+						if(!(Duration() < gap)) {
+							throw std::invalid_argument("sessionWindows: the gap must be positive");
+						}
+					}
+
+					std::optional<Result> operator()() {
+						return this->pull(*this);
+					}
+				};
+
+				template<class E, class TimeOf, class Monoid>
+				using TimeWindowT = TimeWindow<std::decay_t<std::invoke_result_t<TimeOf&, const E&>>, typename Monoid::value_type>;
+			}
+
+			/**************************************************
+			 * Hopping windows over a `Stream` of timestamped events:
+			 * windows `[k * hop, k * hop + size)` for every integer `k`
+			 * (counting from `Time()`), each aggregating, under `monoid`,
+			 * `valueOf(e)` for the events `e` with `timeOf(e)` inside it.
+			 * Windows overlap when `hop < size`.
+			 *
+			 * The watermark is the greatest event time seen so far,
+			 * less `allowedLateness`. A window is emitted, in order
+			 * of start time, as soon as the watermark reaches its end,
+			 * and an event which only belongs to windows already
+			 * emitted is dropped, and counted in the next result's
+			 * `TimeWindow::lateDropped`. Any windows still open when
+			 * `source` ends are flushed.
+			 *
+			 * Aggregation is incremental, so memory is bounded by the
+			 * number of open windows, not events. Within a window,
+			 * values are combined in arrival order.
+			 *
+			 * `Time` may be arithmetic or a `std::chrono::time_point`.
+			 **************************************************/
+			template<class E, class TimeOf, class ValueOf, class Monoid, class Duration>
+			std::shared_ptr<Stream<detail::TimeWindowT<E, TimeOf, Monoid>>> hoppingWindows(std::shared_ptr<Stream<E>> source, TimeOf timeOf, ValueOf valueOf, Monoid monoid, Duration size, Duration hop, Duration allowedLateness = Duration()) {
+				return Stream<detail::TimeWindowT<E, TimeOf, Monoid>>::Generate(detail::AlignedWindowsF<E, TimeOf, ValueOf, Monoid>(
+					std::move(source), std::move(timeOf), std::move(valueOf), std::move(monoid), size, hop, allowedLateness));
+			}
+
+			/// Non-overlapping windows of width `size`. See `hoppingWindows`.
+			template<class E, class TimeOf, class ValueOf, class Monoid, class Duration>
+			std::shared_ptr<Stream<detail::TimeWindowT<E, TimeOf, Monoid>>> tumblingWindows(std::shared_ptr<Stream<E>> source, TimeOf timeOf, ValueOf valueOf, Monoid monoid, Duration size, Duration allowedLateness = Duration()) {
+				return hoppingWindows(std::move(source), std::move(timeOf), std::move(valueOf), std::move(monoid), size, size, allowedLateness);
+			}
+
+			/**************************************************
+			 * Session windows: maximal runs of events each less than
+			 * `gap` after the previous one (in event time). An
+			 * out-of-order event may bridge, and so merge, two
+			 * open sessions. A session ends `gap` after its last
+			 * event, and is emitted once the watermark reaches that.
+			 * Watermarks are as for `hoppingWindows`. An event is only
+			 * late (and dropped) if it is within `gap` of no session
+			 * still open, and its own session would already be closed.
+			 **************************************************/
+			template<class E, class TimeOf, class ValueOf, class Monoid, class Duration>
+			std::shared_ptr<Stream<detail::TimeWindowT<E, TimeOf, Monoid>>> sessionWindows(std::shared_ptr<Stream<E>> source, TimeOf timeOf, ValueOf valueOf, Monoid monoid, Duration gap, Duration allowedLateness = Duration()) {
+				return Stream<detail::TimeWindowT<E, TimeOf, Monoid>>::Generate(detail::SessionWindowsF<E, TimeOf, ValueOf, Monoid>(
+					std::move(source), std::move(timeOf), std::move(valueOf), std::move(monoid), gap, allowedLateness));
+			}
+		}
+	}
+}
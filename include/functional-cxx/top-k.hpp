@@ -0,0 +1,315 @@
+#pragma once
+/************************************************************************************
+ *
+ * Author: Thomas Dickerson
+ * Copyright: 2021, Geopipe, Inc.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ************************************************************************************/
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <iterator>
+#include <memory>
+#include <optional>
+#include <utility>
+#include <vector>
+
+#include <functional-cxx/stream.hpp>
+#include <functional-cxx/support/generators.hpp>
+#include <functional-cxx/support/hashing.hpp>
+#include <functional-cxx/support/open-hash-table.hpp>
+
+namespace com {
+	namespace geopipe {
+		/**************************************************
+		 * Tools for functional programming
+		 **************************************************/
+		namespace functional {
+			/**************************************************
+			 * The `k` greatest elements added, under `Compare`,
+			 * in O(k) memory.
+			 *
+			 * They are kept in a binary heap with the least of them
+			 * on top, so an element which does not make the cut costs
+			 * a single comparison. Ties with the least element kept
+			 * do not displace it.
+			 *
+			 * `addBatch` first filters a whole chunk against the
+			 * current threshold, in a tight loop, and then (if more
+			 * than `k` elements pass) selects the best `k` of those
+			 * with `std::nth_element`, so only they touch the heap.
+			 * Long ranges are processed in blocks of about `2k`
+			 * candidates, so the threshold keeps up with the heap.
+			 **************************************************/
+			template<class E, class Compare = std::less<>>
+			class TopK {
+				/// Heap order: the least element under `Compare` is on top.
+				struct Worse {
+					Compare compare;
+
+					bool operator()(const E& a, const E& b) const {
+						return compare(b, a);
+					}
+				};
+
+				std::size_t k_;
+				Worse worse_;
+				std::vector<E> heap_;
+				std::vector<E> candidates_; ///< Scratch space for `addBatch`.
+
+				static constexpr std::size_t kMinBatch = 256;
+
+				/// Add the best `k` of `candidates_` to the heap, and clear it.
+				void flush() {
+					if(candidates_.size() > k_) {
+						std::nth_element(candidates_.begin(), candidates_.begin() + k_, candidates_.end(), [&](const E& a, const E& b){
+							return worse_.compare(b, a);
+						});
+						candidates_.resize(k_);
+					}
+					for(const E& e : candidates_) {
+						add(e);
+					}
+					candidates_.clear();
+				}
+			public:
+				explicit TopK(std::size_t k, Compare compare = Compare())
+				: k_(k), worse_{std::move(compare)} {
+					heap_.reserve(k);
+				}
+
+				std::size_t k() const {
+					return k_;
+				}
+
+				std::size_t size() const {
+					return heap_.size();
+				}
+
+				/// The least element kept. @pre `size() > 0`
+				const E& threshold() const {
+					return heap_.front();
+				}
+
+				void add(const E& e) {
+					if(heap_.size() < k_) {
+						heap_.push_back(e);
+						std::push_heap(heap_.begin(), heap_.end(), worse_);
+					} else if(k_ && worse_.compare(heap_.front(), e)) {
+						std::pop_heap(heap_.begin(), heap_.end(), worse_);
+						heap_.back() = e;
+						std::push_heap(heap_.begin(), heap_.end(), worse_);
+					}
+				}
+
+				/// Add every element of `[first, last)`.
+				template<class It>
+				void addBatch(It first, It last) {
+					for(; first != last && heap_.size() < k_; ++first) {
+						add(*first);
+					}
+					if(first == last || !k_) {
+						return;
+					}
+					// Flushing whenever the candidates outnumber the heap keeps the threshold fresh.
+					std::size_t limit = std::max<std::size_t>(2 * k_, kMinBatch);
+					candidates_.clear();
+					for(; first != last; ++first) {
+						if(worse_.compare(heap_.front(), *first)) {
+							candidates_.push_back(*first);
+							if(candidates_.size() >= limit) {
+								flush();
+							}
+						}
+					}
+					flush();
+				}
+
+				/// Fold in the elements kept by `other`, e.g. from another shard.
+				void merge(const TopK& other) {
+					addBatch(other.heap_.begin(), other.heap_.end());
+				}
+
+				/// The elements kept, greatest first.
+				std::vector<E> sorted() const {
+					std::vector<E> result(heap_);
+					std::sort_heap(result.begin(), result.end(), worse_);
+					return result;
+				}
+			};
+
+			/**************************************************
+			 * The `k` greatest elements of `source` under `compare`
+			 * (or all of them, if there are fewer), greatest first.
+			 * Pass `std::greater<>` for the `k` least.
+			 *
+			 * `source` is taken by rvalue, and each cell is released
+			 * once visited, so this runs in O(k) memory when the caller
+			 * holds no other reference to the `Stream`.
+			 **************************************************/
+			template<class E, class Compare = std::less<>>
+			std::vector<E> topK(std::shared_ptr<Stream<E>> && source, std::size_t k, Compare compare = Compare()) {
+				TopK<E, Compare> top(k, std::move(compare));
+				detail::consumeStream(std::move(source), [&](const E& e){
+					top.add(e);
+				});
+				return top.sorted();
+			}
+
+			/// As `topK`, for a `Stream` of chunks (any range), which are each fed to `TopK::addBatch`.
+			template<class C, class Compare = std::less<>>
+			std::vector<typename C::value_type> topKChunks(std::shared_ptr<Stream<C>> && chunks, std::size_t k, Compare compare = Compare()) {
+				TopK<typename C::value_type, Compare> top(k, std::move(compare));
+				detail::consumeStream(std::move(chunks), [&](const C& chunk){
+					top.addBatch(std::begin(chunk), std::end(chunk));
+				});
+				return top.sorted();
+			}
+
+			/**************************************************
+			 * A lazy `Stream` of the `k` greatest elements of each
+			 * prefix of `source` under `compare`, greatest first:
+			 * one snapshot per element. Only the O(k) state is
+			 * retained, and no cells of `source`.
+			 **************************************************/
+			template<class E, class Compare = std::less<>>
+			std::shared_ptr<Stream<std::vector<E>>> runningTopK(std::shared_ptr<Stream<E>> source, std::size_t k, Compare compare = Compare()) {
+				return Stream<std::vector<E>>::Generate([input = detail::StreamGen<std::shared_ptr<Stream<E>>>(std::move(source)), top = TopK<E, Compare>(k, std::move(compare))]() mutable -> std::optional<std::vector<E>> {
+					auto e = input();
+					if(!e) {
+						return std::nullopt;
+					}
+					top.add(*e);
+					return top.sorted();
+				});
+			}
+
+			/**************************************************
+			 * The Misra-Gries frequent items summary, in `k` counters.
+			 *
+			 * Every element occurring more than `total() / (k + 1)`
+			 * times is among the `candidates`, and each candidate's
+			 * count is a lower bound on its true frequency, short by
+			 * at most `error()`. When a new element arrives with all
+			 * `k` counters in use, every count (the new one included)
+			 * is reduced by the least, and those reaching zero are
+			 * dropped: since that removes at least `k + 1` from the
+			 * total, this costs amortized O(1) per element.
+			 *
+			 * Summaries merge by adding counts and then reducing back
+			 * to `k` counters in the same way, which preserves the
+			 * error bound over the combined input.
+			 **************************************************/
+			template<class E, class H = detail::Hash<E>, class Eq = std::equal_to<>>
+			class HeavyHitters {
+				std::size_t k_;
+				detail::OpenHashMap<E, std::uint64_t, H, Eq> counters_;
+				std::uint64_t total_;
+				std::uint64_t counted_; ///< The sum of the counters.
+
+				/// Subtract the `(k + 1)`th greatest count from every counter, dropping those left at zero.
+				void reduce() {
+					if(counters_.size() <= k_) {
+						return;
+					}
+					std::vector<std::uint64_t> counts;
+					counts.reserve(counters_.size());
+					counters_.forEach([&](const E&, std::uint64_t count){
+						counts.push_back(count);
+					});
+					std::nth_element(counts.begin(), counts.begin() + k_, counts.end(), std::greater<>());
+					std::uint64_t cut = counts[k_];
+					// Lower every count first, since erasure may shift entries past the sweep.
+					counters_.forEach([&](const E&, std::uint64_t& count){
+						count -= std::min(count, cut);
+					});
+					for(std::size_t i = 0; i < counters_.slotCount(); ++i) {
+						while(counters_.occupied(i) && !counters_.valueAt(i)) {
+							counters_.eraseAt(i);
+						}
+					}
+					// Summed separately: an erasure near the end of the table may wrap an entry already swept around to a later slot.
+					counted_ = 0;
+					counters_.forEach([&](const E&, std::uint64_t count){
+						counted_ += count;
+					});
+				}
+			public:
+				explicit HeavyHitters(std::size_t k, H hash = H(), Eq eq = Eq())
+				: k_(k), counters_(k + 1, std::move(hash), std::move(eq)), total_(0), counted_(0) {}
+
+				std::size_t k() const {
+					return k_;
+				}
+
+				/// The total count of everything added.
+				std::uint64_t total() const {
+					return total_;
+				}
+
+				/// The most by which any candidate's count may fall short.
+				std::uint64_t error() const {
+					return (total_ - counted_) / (k_ + 1);
+				}
+
+				void add(const E& e, std::uint64_t count = 1) {
+					*counters_.tryEmplace(e, 0).first += count;
+					total_ += count;
+					counted_ += count;
+					reduce();
+				}
+
+				/// Fold `other`'s counts into this summary.
+				void merge(const HeavyHitters& other) {
+					other.counters_.forEach([&](const E& e, std::uint64_t count){
+						*counters_.tryEmplace(e, 0).first += count;
+					});
+					total_ += other.total_;
+					counted_ += other.counted_;
+					reduce();
+				}
+
+				/// The elements which may occur more than `total() / (k + 1)` times, with lower bounds on their counts, most frequent first.
+				std::vector<std::pair<E, std::uint64_t>> candidates() const {
+					std::vector<std::pair<E, std::uint64_t>> result;
+					result.reserve(counters_.size());
+					counters_.forEach([&](const E& e, std::uint64_t count){
+						result.emplace_back(e, count);
+					});
+					std::sort(result.begin(), result.end(), [](const auto& a, const auto& b){
+						return a.second > b.second;
+					});
+					return result;
+				}
+			};
+
+			/**************************************************
+			 * The heavy hitters of `source`: see `HeavyHitters`.
+			 * Consumes `source` in O(k) memory, as `topK` does.
+			 **************************************************/
+			template<class E>
+			std::vector<std::pair<E, std::uint64_t>> heavyHitters(std::shared_ptr<Stream<E>> && source, std::size_t k) {
+				HeavyHitters<E> summary(k);
+				detail::consumeStream(std::move(source), [&](const E& e){
+					summary.add(e);
+				});
+				return summary.candidates();
+			}
+		}
+	}
+}
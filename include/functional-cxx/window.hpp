@@ -0,0 +1,311 @@
+#pragma once
+/************************************************************************************
+ *
+ * Author: Thomas Dickerson
+ * Copyright: 2021, Geopipe, Inc.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ************************************************************************************/
+
+#include <algorithm>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <iterator>
+#include <limits>
+#include <memory>
+#include <optional>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include <functional-cxx/stream.hpp>
+#include <functional-cxx/support/generators.hpp>
+
+namespace com {
+	namespace geopipe {
+		/**************************************************
+		 * Tools for functional programming
+		 **************************************************/
+		namespace functional {
+			/**************************************************
+			 * A monoid: an associative `op` with an `identity`,
+			 * for incremental aggregation. `op` need not be
+			 * commutative, nor invertible.
+			 **************************************************/
+			template<class T, class Op>
+			struct Monoid {
+				using value_type = T;
+				T identity;
+				Op op;
+
+				T combine(const T& a, const T& b) const {
+					return op(a, b);
+				}
+			};
+
+			template<class T, class Op>
+			Monoid<T, Op> monoid(T identity, Op op) {
+				return Monoid<T, Op>{std::move(identity), std::move(op)};
+			}
+
+			template<class T>
+			Monoid<T, std::plus<>> sumMonoid() {
+				return monoid(T(), std::plus<>());
+			}
+
+			/// Requires `std::numeric_limits<T>`; for other types, use `monoid` with a suitable identity.
+			template<class T>
+			auto minMonoid() {
+				return monoid(std::numeric_limits<T>::has_infinity ? std::numeric_limits<T>::infinity() : std::numeric_limits<T>::max(), [](const T& a, const T& b){
+					return std::min(a, b);
+				});
+			}
+
+			/// Requires `std::numeric_limits<T>`; for other types, use `monoid` with a suitable identity.
+			template<class T>
+			auto maxMonoid() {
+				return monoid(std::numeric_limits<T>::has_infinity ? -std::numeric_limits<T>::infinity() : std::numeric_limits<T>::lowest(), [](const T& a, const T& b){
+					return std::max(a, b);
+				});
+			}
+
+			/**************************************************
+			 * A persistent view of `size` consecutive cells of a
+			 * `Stream`, emitted by `window`. It costs O(1) to create,
+			 * since it shares (and retains) the underlying cells.
+			 **************************************************/
+			template<class E>
+			class Window {
+				std::shared_ptr<Stream<E>> first_;
+				std::size_t size_;
+			public:
+				class Iterator {
+					friend class Window;
+					std::shared_ptr<Stream<E>> cell_;
+					std::size_t remaining_;
+					Iterator(std::shared_ptr<Stream<E>> cell, std::size_t remaining) : cell_(std::move(cell)), remaining_(remaining) {}
+				public:
+					using iterator_category = std::forward_iterator_tag;
+					using value_type = E;
+					using difference_type = std::ptrdiff_t;
+					using pointer = const E*;
+					using reference = const E&;
+
+					const E& operator*() const {
+						return cell_->head();
+					}
+
+					Iterator& operator++() {
+						if(--remaining_) {
+							cell_ = cell_->tail();
+						} else {
+							cell_ = nullptr;
+						}
+						return *this;
+					}
+
+					bool operator==(const Iterator& other) const {
+						return remaining_ == other.remaining_;
+					}
+
+					bool operator!=(const Iterator& other) const {
+						return remaining_ != other.remaining_;
+					}
+				};
+
+				Window(std::shared_ptr<Stream<E>> first, std::size_t size)
+				: first_(std::move(first)), size_(size) {}
+
+				std::size_t size() const {
+					return size_;
+				}
+
+				/// The oldest element in the window.
+				const E& front() const {
+					return first_->head();
+				}
+
+				Iterator begin() const {
+					return Iterator(first_, size_);
+				}
+
+				Iterator end() const {
+					return Iterator(nullptr, 0);
+				}
+			};
+
+			/**************************************************
+			 * Internal implementation details
+			 **************************************************/
+			namespace detail {
+				/**************************************************
+				 * A FIFO queue with O(1) amortized aggregation under a
+				 * monoid, by the "two stacks" construction: the newer
+				 * elements sit in `back_` with their running aggregate,
+				 * and the older ones in `front_`, as suffix aggregates.
+				 * When `front_` runs dry, `back_` is flipped into it.
+				 **************************************************/
+				template<class Monoid>
+				class TwoStackAggregator {
+					using T = typename Monoid::value_type;
+					Monoid monoid_;
+					std::vector<T> front_; ///< Suffix aggregates of the older elements, oldest last.
+					std::vector<T> back_; ///< The newer elements, in order.
+					T backAggregate_;
+				public:
+					explicit TwoStackAggregator(Monoid monoid)
+					: monoid_(std::move(monoid)), backAggregate_(monoid_.identity) {}
+
+					void reserve(std::size_t n) {
+						front_.reserve(n);
+						back_.reserve(n);
+					}
+
+					void push(T value) {
+						backAggregate_ = monoid_.combine(backAggregate_, value);
+						back_.push_back(std::move(value));
+					}
+
+					void pop() {
+						if(front_.empty()) {
+							T suffix = monoid_.identity;
+							for(auto it = back_.rbegin(); it != back_.rend(); ++it) {
+								suffix = monoid_.combine(*it, suffix);
+								front_.push_back(suffix);
+							}
+							back_.clear();
+							backAggregate_ = monoid_.identity;
+						}
+						front_.pop_back();
+					}
+
+					T aggregate() const {
+						return front_.empty() ? backAggregate_ : monoid_.combine(front_.back(), backAggregate_);
+					}
+				};
+			}
+
+			/**************************************************
+			 * A lazy `Stream` of the sliding windows of `w` consecutive
+			 * elements of `source`, one per element from the `w`th on.
+			 * Each `Window` shares the cells of `source`, so emitting one
+			 * is O(1), and the pipeline retains only O(w) cells.
+			 * A `source` shorter than `w` yields no windows.
+			 **************************************************/
+			template<class E>
+			std::shared_ptr<Stream<Window<E>>> window(std::shared_ptr<Stream<E>> source, std::size_t w) {
+				if(!w) {
+					throw std::invalid_argument("window: the window size must be positive");
+				}
+				std::shared_ptr<Stream<E>> last = source;
+				for(std::size_t i = 1; last && i < w; ++i) {
+					last = last->tail();
+				}
+				if(!last) {
+					return nullptr;
+				}
+				return Stream<Window<E>>::Generate([first = std::move(source), last = std::move(last), w, started = false]() mutable -> std::optional<Window<E>> {
+					if(started) {
+						last = last->tail();
+						if(!last) {
+							first = nullptr;
+							return std::nullopt;
+						}
+						first = first->tail();
+					}
+					started = true;
+					return Window<E>(first, w);
+				});
+			}
+
+			/**************************************************
+			 * A lazy `Stream` of the aggregates, under `monoid`, of the
+			 * sliding windows of `w` consecutive elements of `source`,
+			 * one per element from the `w`th on.
+			 *
+			 * Uses the "two stacks" algorithm, so each result costs
+			 * amortized O(1) `monoid.combine`s, however expensive the
+			 * aggregate is to invert (or if it cannot be, as for min/max).
+			 * Only O(w) aggregates are retained, and no cells of `source`.
+			 * Elements are converted to `Monoid::value_type`.
+			 **************************************************/
+			template<class E, class Monoid>
+			std::shared_ptr<Stream<typename Monoid::value_type>> windowAggregate(std::shared_ptr<Stream<E>> source, std::size_t w, Monoid monoid) {
+				using T = typename Monoid::value_type;
+				if(!w) {
+					throw std::invalid_argument("windowAggregate: the window size must be positive");
+				}
+				detail::TwoStackAggregator<Monoid> window(std::move(monoid));
+				window.reserve(w);
+				return Stream<T>::Generate([input = detail::StreamGen<std::shared_ptr<Stream<E>>>(std::move(source)), window = std::move(window), w, filled = std::size_t(0)]() mutable -> std::optional<T> {
+					for(;;) {
+						auto e = input();
+						if(!e) {
+							return std::nullopt;
+						}
+						if(filled == w) {
+							window.pop();
+						} else {
+							++filled;
+						}
+						window.push(T(std::move(*e)));
+						if(filled == w) {
+							return window.aggregate();
+						}
+					}
+				});
+			}
+
+			/**************************************************
+			 * A lazy `Stream` of the least element (under `compare`)
+			 * of each sliding window of `w` consecutive elements of
+			 * `source`, one per element from the `w`th on.
+			 *
+			 * Uses a monotonic deque: an element is discarded as soon
+			 * as a newer one compares no greater, since it can never
+			 * again be the minimum. This costs amortized O(1)
+			 * comparisons per element, and is cheaper than
+			 * `windowAggregate` with `minMonoid` when only the
+			 * extremum is needed. Pass `std::greater<>` for maxima.
+			 **************************************************/
+			template<class E, class Compare = std::less<>>
+			std::shared_ptr<Stream<E>> windowMin(std::shared_ptr<Stream<E>> source, std::size_t w, Compare compare = Compare()) {
+				if(!w) {
+					throw std::invalid_argument("windowMin: the window size must be positive");
+				}
+				return Stream<E>::Generate([input = detail::StreamGen<std::shared_ptr<Stream<E>>>(std::move(source)), candidates = std::deque<std::pair<std::size_t, E>>(), compare = std::move(compare), w, index = std::size_t(0)]() mutable -> std::optional<E> {
+					for(;;) {
+						auto e = input();
+						if(!e) {
+							return std::nullopt;
+						}
+						while(!candidates.empty() && !compare(candidates.back().second, *e)) {
+							candidates.pop_back();
+						}
+						candidates.emplace_back(index, std::move(*e));
+						if(candidates.front().first + w <= index) {
+							candidates.pop_front();
+						}
+						if(++index >= w) {
+							return candidates.front().second;
+						}
+					}
+				});
+			}
+		}
+	}
+}